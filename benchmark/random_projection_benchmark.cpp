@@ -0,0 +1,100 @@
+#include "comp6771/random_projection.hpp"
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+/*
+   Candidate filtering: the distance from one query to every candidate, computed exactly in d
+   dimensions or approximately after projecting to k dimensions. The projected benchmarks include
+   projecting the query, and report the distortion |projected / exact - 1| of the distances they
+   computed as mean_distortion and max_distortion.
+*/
+
+namespace {
+	using size_type = comp6771::euclidean_vector::size_type;
+	constexpr auto candidates = size_type{256};
+
+	auto make_points(size_type count, size_type dim, std::uint64_t seed)
+	   -> std::vector<comp6771::euclidean_vector> {
+		auto points = std::vector<comp6771::euclidean_vector>();
+		auto state = seed;
+		for (auto p = size_type{0}; p < count; ++p) {
+			auto v = comp6771::euclidean_vector(dim);
+			for (auto i = size_type{0}; i < dim; ++i) {
+				state = state * 6364136223846793005U + 1442695040888963407U;
+				v[i] = static_cast<double>(state >> 11U) / 4503599627370496.0 * 2 - 1;
+			}
+			points.push_back(v);
+		}
+		return points;
+	}
+
+	auto exact_distances(benchmark::State& state) -> void {
+		auto const d = state.range(0);
+		auto const data = make_points(candidates, d, 1);
+		auto const query = make_points(1, d, 2).front();
+		for (auto _ : state) {
+			for (auto const& c : data) {
+				benchmark::DoNotOptimize(euclidean_norm(query - c));
+			}
+		}
+		state.SetItemsProcessed(state.iterations() * candidates);
+	}
+
+	auto projected_distances(benchmark::State& state,
+	                         comp6771::random_projection::distribution dist) -> void {
+		auto const d = state.range(0);
+		auto const k = state.range(1);
+		auto const data = make_points(candidates, d, 1);
+		auto const query = make_points(1, d, 2).front();
+		auto const rp = comp6771::random_projection(d, k, 2021, dist);
+		// Candidates are projected once, ahead of time; only the query is projected per search.
+		auto const projected = rp(data);
+
+		auto projected_query = comp6771::euclidean_vector(k);
+		for (auto _ : state) {
+			rp.project_into(query, projected_query);
+			for (auto const& c : projected) {
+				benchmark::DoNotOptimize(euclidean_norm(projected_query - c));
+			}
+		}
+		state.SetItemsProcessed(state.iterations() * candidates);
+
+		auto total = 0.0;
+		auto worst = 0.0;
+		for (auto i = std::size_t{0}; i < data.size(); ++i) {
+			auto const exact = euclidean_norm(query - data[i]);
+			auto const approx = euclidean_norm(projected_query - projected[i]);
+			auto const distortion = std::abs(approx / exact - 1);
+			total += distortion;
+			worst = std::max(worst, distortion);
+		}
+		state.counters["mean_distortion"] = total / static_cast<double>(data.size());
+		state.counters["max_distortion"] = worst;
+	}
+
+	auto achlioptas_distances(benchmark::State& state) -> void {
+		projected_distances(state, comp6771::random_projection::distribution::achlioptas);
+	}
+	auto gaussian_distances(benchmark::State& state) -> void {
+		projected_distances(state, comp6771::random_projection::distribution::gaussian);
+	}
+
+	// Projecting a whole batch at once, which generates each matrix row once.
+	auto project_batch(benchmark::State& state) -> void {
+		auto const d = state.range(0);
+		auto const k = state.range(1);
+		auto const data = make_points(candidates, d, 1);
+		auto const rp = comp6771::random_projection(d, k, 2021);
+		for (auto _ : state) {
+			benchmark::DoNotOptimize(rp(data));
+		}
+		state.SetItemsProcessed(state.iterations() * candidates);
+	}
+} // namespace
+
+BENCHMARK(exact_distances)->Arg(10'000)->Arg(50'000);
+BENCHMARK(achlioptas_distances)->ArgsProduct({{10'000, 50'000}, {32, 128, 512}});
+BENCHMARK(gaussian_distances)->ArgsProduct({{10'000, 50'000}, {32, 128, 512}});
+BENCHMARK(project_batch)->ArgsProduct({{10'000}, {32, 128, 512}});
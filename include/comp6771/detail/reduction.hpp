@@ -0,0 +1,35 @@
+#ifndef COMP6771_DETAIL_REDUCTION_HPP
+#define COMP6771_DETAIL_REDUCTION_HPP
+
+#include <cstddef>
+#include <functional>
+
+// Building blocks of reduction::reproducible, shared by every vector type so that the same
+// components always reduce to the same bits, whether they live in memory or in a mapped file.
+namespace comp6771::detail {
+	// Components per block. This is part of the result: changing it changes the bits returned.
+	constexpr auto reduction_block = std::size_t{4096};
+
+	// Number of blocks needed to cover n components.
+	constexpr auto reduction_blocks(std::size_t n) noexcept -> std::size_t {
+		return (n + reduction_block - 1) / reduction_block;
+	}
+
+	// Splits blocks [0, blocks) into contiguous ranges, one per worker, and calls f(first, last)
+	// once for each range. Uses up to `threads` workers (every hardware thread when threads <= 0),
+	// one of which is the calling thread; f must not throw.
+	auto for_each_block_range(std::size_t blocks,
+	                          int threads,
+	                          std::function<void(std::size_t first, std::size_t last)> const& f)
+	   -> void;
+
+	// Writes the sum of x[i] * y[i] over each block of [0, n) to partial[0, reduction_blocks(n)),
+	// spreading the blocks over up to `threads` threads (every hardware thread when threads <= 0).
+	auto reduce_blocks(double const* x, double const* y, std::size_t n, int threads, double* partial)
+	   -> void;
+
+	// Pairwise sum of p[0, n); the order of additions depends on n alone.
+	auto pairwise_sum(double const* p, std::size_t n) noexcept -> double;
+} // namespace comp6771::detail
+
+#endif // COMP6771_DETAIL_REDUCTION_HPP
@@ -0,0 +1,135 @@
+#ifndef COMP6771_DETAIL_SPSC_QUEUE_HPP
+#define COMP6771_DETAIL_SPSC_QUEUE_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace comp6771::detail {
+	// A bounded, lock-free, single-producer single-consumer ring buffer. try_push and try_pop never
+	// block or allocate; they fail when the queue is full or empty. A caller that wants to wait can
+	// park in wait_until_pushable or wait_until_poppable, which sleep (via std::atomic::wait) until
+	// the other side makes progress, the queue is closed, or wake is called.
+	// Exactly one thread may push and exactly one thread may pop at any time.
+	template<typename T>
+	class spsc_queue {
+	public:
+		// The capacity is rounded up to a power of two.
+		explicit spsc_queue(std::size_t capacity)
+		: slots_(std::bit_ceil(std::max(capacity, std::size_t{1})))
+		, mask_{slots_.size() - 1} {}
+
+		spsc_queue(spsc_queue const&) = delete;
+		auto operator=(spsc_queue const&) -> spsc_queue& = delete;
+
+		// Moves `value` into the queue unless it is full; on failure `value` is untouched.
+		auto try_push(T& value) -> bool {
+			auto const tail = tail_.load(std::memory_order_relaxed);
+			if (tail - head_cache_ == slots_.size()) {
+				head_cache_ = head_.load(std::memory_order_acquire);
+				if (tail - head_cache_ == slots_.size()) {
+					return false;
+				}
+			}
+			slots_[tail & mask_] = std::move(value);
+			tail_.store(tail + 1, std::memory_order_release);
+			signal_waiters();
+			return true;
+		}
+		// Moves the oldest element into `value` unless the queue is empty.
+		auto try_pop(T& value) -> bool {
+			auto const head = head_.load(std::memory_order_relaxed);
+			if (head == tail_cache_) {
+				tail_cache_ = tail_.load(std::memory_order_acquire);
+				if (head == tail_cache_) {
+					return false;
+				}
+			}
+			value = std::move(slots_[head & mask_]);
+			head_.store(head + 1, std::memory_order_release);
+			signal_waiters();
+			return true;
+		}
+		// Called by the producer after its last push.
+		auto close() noexcept -> void {
+			closed_.store(true, std::memory_order_release);
+			signal();
+		}
+		// Wakes any thread parked on this queue, e.g. after setting its `cancel` flag.
+		auto wake() noexcept -> void {
+			signal();
+		}
+		// Producer: sleeps until the queue may have room, or `cancel` is set before a wake().
+		auto wait_until_pushable(std::atomic<bool> const& cancel) noexcept -> void {
+			park([&] {
+				return cancel.load(std::memory_order_acquire)
+				       || tail_.load(std::memory_order_relaxed) - head_.load(std::memory_order_acquire)
+				             < slots_.size();
+			});
+		}
+		// Consumer: sleeps until the queue may hold an element or be closed, or `cancel` is set
+		// before a wake().
+		auto wait_until_poppable(std::atomic<bool> const& cancel) noexcept -> void {
+			park([&] {
+				return cancel.load(std::memory_order_acquire) || closed()
+				       || head_.load(std::memory_order_relaxed)
+				             != tail_.load(std::memory_order_acquire);
+			});
+		}
+		// True once the producer has closed the queue. Everything it pushed is visible to a
+		// try_pop made after this returns true.
+		[[nodiscard]] auto closed() const noexcept -> bool {
+			return closed_.load(std::memory_order_acquire);
+		}
+		[[nodiscard]] auto capacity() const noexcept -> std::size_t {
+			return slots_.size();
+		}
+
+	private:
+		// A parked thread registers in waiters_, then reads signal_, then checks its condition and
+		// sleeps until signal_ changes. A push or pop only bumps signal_ when, after storing its
+		// index, it sees a registered waiter: the two seq_cst fences guarantee that either the
+		// pusher sees the waiter or the waiter sees the new index, so no wake-up is lost and an
+		// uncontended push or pop never writes to the shared line.
+		template<typename Ready>
+		auto park(Ready const& ready) noexcept -> void {
+			waiters_.fetch_add(1, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			auto const seen = signal_.load(std::memory_order_acquire);
+			if (!ready()) {
+				signal_.wait(seen, std::memory_order_acquire);
+			}
+			waiters_.fetch_sub(1, std::memory_order_relaxed);
+		}
+		auto signal_waiters() noexcept -> void {
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			if (waiters_.load(std::memory_order_relaxed) != 0) {
+				signal();
+			}
+		}
+		auto signal() noexcept -> void {
+			signal_.fetch_add(1, std::memory_order_acq_rel);
+			signal_.notify_all();
+		}
+
+		// Keeps the producer's and consumer's indices on separate cache lines.
+		static constexpr auto cache_line = std::size_t{64};
+
+		std::vector<T> slots_;
+		std::size_t mask_;
+		alignas(cache_line) std::atomic<std::size_t> head_{0};
+		std::size_t tail_cache_{0}; // consumer's last view of tail_
+		alignas(cache_line) std::atomic<std::size_t> tail_{0};
+		std::size_t head_cache_{0}; // producer's last view of head_
+		alignas(cache_line) std::atomic<bool> closed_{false};
+		// Touched only while someone is parked, so kept off the index lines.
+		alignas(cache_line) std::atomic<std::uint32_t> signal_{0};
+		std::atomic<std::uint32_t> waiters_{0};
+	};
+} // namespace comp6771::detail
+
+#endif // COMP6771_DETAIL_SPSC_QUEUE_HPP
@@ -2,6 +2,7 @@
 #define COMP6771_EUCLIDEAN_VECTOR_HPP
 
 #include <algorithm>
+#include <cstdint>
 #include <list>
 #include <memory>
 #include <stdexcept>
@@ -15,11 +16,20 @@ namespace comp6771 {
 		: std::runtime_error(what) {}
 	};
 
+	// Selects how dot and euclidean_norm accumulate their sum of products.
+	//   sequential:   a single left-to-right accumulator (the original behaviour).
+	//   reproducible: fixed-size blocks summed in fixed lanes, then combined pairwise. The result is
+	//                 bit-identical for any thread count or instruction set.
+	enum class reduction { sequential, reproducible };
+
 	class euclidean_vector {
 	public:
+		// Dimensions and indices are 64-bit so a vector is not capped at 2^31 components.
+		using size_type = std::int64_t;
+
 		euclidean_vector() noexcept;
-		explicit euclidean_vector(int dim) noexcept;
-		explicit euclidean_vector(int dim, double v) noexcept;
+		explicit euclidean_vector(size_type dim) noexcept;
+		explicit euclidean_vector(size_type dim, double v) noexcept;
 		euclidean_vector(std::vector<double>::const_iterator begin,
 		                 std::vector<double>::const_iterator end) noexcept;
 		euclidean_vector(std::initializer_list<double> list) noexcept;
@@ -28,8 +38,8 @@ namespace comp6771 {
 		~euclidean_vector() = default;
 		auto operator=(euclidean_vector const& ev) -> euclidean_vector&;
 		auto operator=(euclidean_vector&& ev) noexcept -> euclidean_vector&;
-		auto operator[](int index) -> double&;
-		auto operator[](int index) const -> const double&;
+		auto operator[](size_type index) -> double&;
+		auto operator[](size_type index) const -> const double&;
 		auto operator+() const -> euclidean_vector;
 		auto operator-() const -> euclidean_vector;
 		auto operator+=(euclidean_vector const& ev) -> euclidean_vector&;
@@ -39,9 +49,9 @@ namespace comp6771 {
 		explicit operator std::vector<double>() const;
 		explicit operator std::list<double>() const;
 
-		[[nodiscard]] auto at(int index) const -> double;
-		auto at(int index) -> double&;
-		[[nodiscard]] auto dimensions() const -> int;
+		[[nodiscard]] auto at(size_type index) const -> double;
+		auto at(size_type index) -> double&;
+		[[nodiscard]] auto dimensions() const -> size_type;
 		friend auto operator==(euclidean_vector const& ev1, euclidean_vector const& ev2) -> bool;
 		friend auto operator!=(euclidean_vector const& ev1, euclidean_vector const& ev2) -> bool;
 		friend auto operator+(euclidean_vector const& ev1, euclidean_vector const& ev2)
@@ -52,12 +62,21 @@ namespace comp6771 {
 		friend auto operator*(double coef, euclidean_vector const& ev) -> euclidean_vector;
 		friend auto operator/(euclidean_vector const& ev, double divisor) -> euclidean_vector;
 		friend auto operator<<(std::ostream& os, euclidean_vector const& ev) -> std::ostream&;
+		// Exchanges storage (and any cached norm) without allocating.
+		friend auto swap(euclidean_vector& ev1, euclidean_vector& ev2) noexcept -> void;
 		friend auto euclidean_norm(euclidean_vector const& v) -> double;
 		friend auto dot(euclidean_vector const& x, euclidean_vector const& y) -> double;
+		friend auto euclidean_norm(euclidean_vector const& v, reduction mode) -> double;
+		friend auto euclidean_norm(euclidean_vector const& v, reduction mode, int threads) -> double;
+		friend auto dot(euclidean_vector const& x, euclidean_vector const& y, reduction mode)
+		   -> double;
+		friend auto
+		dot(euclidean_vector const& x, euclidean_vector const& y, reduction mode, int threads)
+		   -> double;
 
 	private:
 		mutable std::unique_ptr<double> norm_;
-		int dimension_;
+		size_type dimension_;
 		// ass2 spec requires we use double[]
 		// NOLINTNEXTLINE(modernize-avoid-c-arrays)
 		std::unique_ptr<double[]> magnitude_;
@@ -0,0 +1,107 @@
+#ifndef COMP6771_MAPPED_EUCLIDEAN_VECTOR_HPP
+#define COMP6771_MAPPED_EUCLIDEAN_VECTOR_HPP
+
+#include "comp6771/euclidean_vector.hpp"
+#include <string>
+
+namespace comp6771 {
+	// A euclidean vector whose magnitudes live in a memory-mapped file of raw doubles, so it may be
+	// far larger than RAM. Whole-vector operations stream through the file in chunks and ask the
+	// kernel to read the next chunk ahead while the current one is processed.
+	//
+	// Results of binary operators are written to an unnamed temporary file in the directory of the
+	// left-hand operand, so they are out-of-core as well.
+	class mapped_euclidean_vector {
+	public:
+		using size_type = euclidean_vector::size_type;
+		// How open maps an existing file.
+		enum class access { read_only, read_write };
+
+		// Creates (or truncates) `path` to hold `dim` magnitudes, all equal to `v`. A zero `v`
+		// leaves the file sparse, so creating a huge vector costs no disk space up front.
+		static auto create(std::string const& path, size_type dim, double v = 0.0)
+		   -> mapped_euclidean_vector;
+		// Maps an existing file of raw doubles. A read_only vector needs only read permission on
+		// the file; modifying it through a non-const operator[], at or compound operator throws.
+		// Read it through a const reference, and the const overloads are used instead.
+		static auto open(std::string const& path, access mode = access::read_write)
+		   -> mapped_euclidean_vector;
+
+		mapped_euclidean_vector(mapped_euclidean_vector const& ev) = delete;
+		mapped_euclidean_vector(mapped_euclidean_vector&& ev) noexcept;
+		~mapped_euclidean_vector();
+		auto operator=(mapped_euclidean_vector const& ev) -> mapped_euclidean_vector& = delete;
+		auto operator=(mapped_euclidean_vector&& ev) noexcept -> mapped_euclidean_vector&;
+		auto operator[](size_type index) -> double&;
+		auto operator[](size_type index) const -> const double&;
+		auto operator+() const -> mapped_euclidean_vector;
+		auto operator-() const -> mapped_euclidean_vector;
+		auto operator+=(mapped_euclidean_vector const& ev) -> mapped_euclidean_vector&;
+		auto operator-=(mapped_euclidean_vector const& ev) -> mapped_euclidean_vector&;
+		auto operator*=(double coefficient) -> mapped_euclidean_vector&;
+		auto operator/=(double divisor) -> mapped_euclidean_vector&;
+		explicit operator euclidean_vector() const;
+
+		[[nodiscard]] auto at(size_type index) const -> double;
+		auto at(size_type index) -> double&;
+		[[nodiscard]] auto dimensions() const -> size_type;
+		[[nodiscard]] auto writable() const -> bool;
+		// Path of the backing file; empty for the temporaries produced by operators.
+		[[nodiscard]] auto path() const -> std::string const&;
+		// Writes dirty pages back to the file and waits for completion.
+		auto flush() -> void;
+
+		friend auto operator==(mapped_euclidean_vector const& ev1, mapped_euclidean_vector const& ev2)
+		   -> bool;
+		friend auto operator!=(mapped_euclidean_vector const& ev1, mapped_euclidean_vector const& ev2)
+		   -> bool;
+		friend auto operator+(mapped_euclidean_vector const& ev1, mapped_euclidean_vector const& ev2)
+		   -> mapped_euclidean_vector;
+		friend auto operator-(mapped_euclidean_vector const& ev1, mapped_euclidean_vector const& ev2)
+		   -> mapped_euclidean_vector;
+		friend auto operator*(mapped_euclidean_vector const& ev, double coef)
+		   -> mapped_euclidean_vector;
+		friend auto operator*(double coef, mapped_euclidean_vector const& ev)
+		   -> mapped_euclidean_vector;
+		friend auto operator/(mapped_euclidean_vector const& ev, double divisor)
+		   -> mapped_euclidean_vector;
+		// Without a mode, dot and euclidean_norm use reduction::reproducible, whose result is
+		// bit-identical to the same components held in a euclidean_vector. As for euclidean_vector,
+		// `threads` bounds the workers of a reproducible reduction; threads <= 0 uses every
+		// hardware thread.
+		friend auto euclidean_norm(mapped_euclidean_vector const& v) -> double;
+		friend auto euclidean_norm(mapped_euclidean_vector const& v, reduction mode) -> double;
+		friend auto euclidean_norm(mapped_euclidean_vector const& v, reduction mode, int threads)
+		   -> double;
+		friend auto dot(mapped_euclidean_vector const& x, mapped_euclidean_vector const& y) -> double;
+		friend auto
+		dot(mapped_euclidean_vector const& x, mapped_euclidean_vector const& y, reduction mode)
+		   -> double;
+		friend auto dot(mapped_euclidean_vector const& x,
+		                mapped_euclidean_vector const& y,
+		                reduction mode,
+		                int threads) -> double;
+
+	private:
+		mapped_euclidean_vector(std::string path,
+		                        std::string directory,
+		                        int fd,
+		                        size_type dim,
+		                        access mode = access::read_write);
+		// Throws unless the mapping may be written.
+		auto check_writable() const -> void;
+		// An unnamed file next to `ev` with room for dim magnitudes.
+		static auto temporary(mapped_euclidean_vector const& ev, size_type dim)
+		   -> mapped_euclidean_vector;
+
+		std::string path_;
+		// Where temporaries derived from this vector are created.
+		std::string directory_;
+		int fd_;
+		size_type dimension_;
+		double* magnitude_;
+		bool writable_;
+	};
+
+} // namespace comp6771
+#endif // COMP6771_MAPPED_EUCLIDEAN_VECTOR_HPP
@@ -0,0 +1,74 @@
+#ifndef COMP6771_RANDOM_PROJECTION_HPP
+#define COMP6771_RANDOM_PROJECTION_HPP
+
+#include "comp6771/euclidean_vector.hpp"
+#include <cstdint>
+#include <vector>
+
+namespace comp6771 {
+	// A Johnson-Lindenstrauss random projection from input_dimensions() down to
+	// output_dimensions(). Distances between projected vectors approximate the original distances,
+	// so they can be used to filter candidates before exact work with dot or euclidean_norm.
+	//
+	// The k x d matrix is never stored. Each entry is a pure function of (seed, row, column), so
+	// rows are regenerated on demand and two projections with the same seed are identical.
+	class random_projection {
+	public:
+		using size_type = euclidean_vector::size_type;
+
+		// gaussian:   dense entries drawn from N(0, 1/k).
+		// achlioptas: sparse entries sqrt(3/k) * {+1, 0, -1} with probabilities {1/6, 2/3, 1/6};
+		//             each is decoded from 16 random bits, far more cheaply than a Gaussian one.
+		enum class distribution { gaussian, achlioptas };
+
+		random_projection(size_type input_dim,
+		                  size_type output_dim,
+		                  std::uint64_t seed,
+		                  distribution dist = distribution::achlioptas);
+
+		// Projects one vector.
+		auto operator()(euclidean_vector const& v) const -> euclidean_vector;
+		// Projects a batch; each row of the matrix is generated once for the whole batch.
+		auto operator()(std::vector<euclidean_vector> const& batch) const
+		   -> std::vector<euclidean_vector>;
+		// Projects v into out, reusing out's storage when it already has output_dimensions().
+		auto project_into(euclidean_vector const& v, euclidean_vector& out) const -> void;
+
+		// Buffers for projecting batches. Passing the same workspace to every call means
+		// projecting a batch allocates nothing once the buffers have grown to fit.
+		class workspace {
+			friend class random_projection;
+			std::vector<double> row_;
+			std::vector<double const*> inputs_;
+		};
+		// Projects *in[i] into *out[i] for every i, generating each row of the matrix once for
+		// the whole batch. Each out[i] is reused when it already has output_dimensions(); none
+		// may be one of the inputs.
+		auto project_into(std::vector<euclidean_vector const*> const& in,
+		                  std::vector<euclidean_vector*> const& out,
+		                  workspace& ws) const -> void;
+
+		// Entry (row, column) of the (scaled) projection matrix.
+		[[nodiscard]] auto entry(size_type row, size_type column) const -> double;
+		[[nodiscard]] auto input_dimensions() const -> size_type;
+		[[nodiscard]] auto output_dimensions() const -> size_type;
+		[[nodiscard]] auto seed() const -> std::uint64_t;
+		[[nodiscard]] auto kind() const -> distribution;
+
+		// Smallest output dimension for which the Johnson-Lindenstrauss lemma keeps every pairwise
+		// distance among `points` vectors within a factor of (1 +/- epsilon), with high probability.
+		static auto jl_dimension(size_type points, double epsilon) -> size_type;
+
+	private:
+		// Projects one vector, generating each entry as it is used; allocates nothing.
+		auto project_one(double const* x, euclidean_vector& out) const -> void;
+
+		size_type input_dimension_;
+		size_type output_dimension_;
+		std::uint64_t seed_;
+		distribution distribution_;
+		double scale_;
+	};
+
+} // namespace comp6771
+#endif // COMP6771_RANDOM_PROJECTION_HPP
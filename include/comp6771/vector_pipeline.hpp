@@ -0,0 +1,127 @@
+#ifndef COMP6771_VECTOR_PIPELINE_HPP
+#define COMP6771_VECTOR_PIPELINE_HPP
+
+#include "comp6771/detail/spsc_queue.hpp"
+#include "comp6771/euclidean_vector.hpp"
+#include "comp6771/random_projection.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace comp6771 {
+	// Counters for one stage of a vector_pipeline, as returned by vector_pipeline::stats().
+	struct stage_stats {
+		std::string name;
+		std::uint64_t items_in = 0;
+		std::uint64_t items_out = 0;
+		std::uint64_t batches = 0;
+		// Time spent running the stage on its batches.
+		std::chrono::nanoseconds busy{0};
+		// Time spent waiting for room downstream, i.e. held back by backpressure.
+		std::chrono::nanoseconds blocked{0};
+		// Latency of a batch from the moment the source started it until this stage finished it.
+		std::chrono::nanoseconds total_latency{0};
+		std::chrono::nanoseconds max_latency{0};
+
+		// Items processed per second of busy time.
+		[[nodiscard]] auto throughput() const -> double;
+		[[nodiscard]] auto mean_latency() const -> std::chrono::nanoseconds;
+	};
+
+	// Streams euclidean_vectors from a source, through a chain of stages, to a sink. Every stage
+	// runs on a thread of its own, connected to its neighbours by bounded lock-free queues of
+	// micro-batches. A full queue holds its producer back, so a slow stage throttles the source
+	// rather than letting work pile up.
+	//
+	// Vectors are not allocated per item: batches, and the vectors in them, travel from the sink
+	// back to the source through a pool and are refilled in place.
+	class vector_pipeline {
+		struct item;
+
+	public:
+		// The live vectors of a micro-batch, each with the spare that travels with it.
+		class batch_view {
+		public:
+			[[nodiscard]] auto size() const -> std::size_t;
+			[[nodiscard]] auto value(std::size_t i) const -> euclidean_vector&;
+			[[nodiscard]] auto scratch(std::size_t i) const -> euclidean_vector&;
+
+		private:
+			friend class vector_pipeline;
+			batch_view(item* items, std::size_t size);
+
+			item* items_;
+			std::size_t size_;
+		};
+
+		// Transforms `v` in place; returning false drops it. `scratch` is a spare vector that stays
+		// with `v` and may be swapped with it, e.g. to change dimension without allocating.
+		using stage_function = std::function<bool(euclidean_vector& v, euclidean_vector& scratch)>;
+		// Transforms every vector of a micro-batch in place, e.g. to share work across the batch.
+		using batch_stage_function = std::function<void(batch_view items)>;
+		// Fills `v`, which holds a recycled buffer; returns false once there is nothing left.
+		using source_function = std::function<bool(euclidean_vector& v)>;
+		using sink_function = std::function<void(euclidean_vector const& v)>;
+
+		struct options {
+			// Vectors per micro-batch.
+			std::size_t batch_size = 64;
+			// Batches each queue between two stages can hold.
+			std::size_t queue_capacity = 8;
+		};
+
+		vector_pipeline();
+		explicit vector_pipeline(options opts);
+		vector_pipeline(vector_pipeline const&) = delete;
+		auto operator=(vector_pipeline const&) -> vector_pipeline& = delete;
+		~vector_pipeline();
+
+		// Appends a stage; stages run in the order they were added.
+		auto add_stage(std::string name, stage_function f) -> vector_pipeline&;
+		auto add_stage(std::string name, batch_stage_function f) -> vector_pipeline&;
+		// Runs until `source` is exhausted and every surviving vector has reached `sink`. The
+		// source runs on the calling thread. If any stage, source or sink throws, the pipeline
+		// stops and run rethrows the first exception.
+		auto run(source_function const& source, sink_function const& sink) -> void;
+
+		// Counters for the source, each stage and the sink, in that order, from the latest run.
+		[[nodiscard]] auto stats() const -> std::vector<stage_stats>;
+		// Batches allocated because the pool was empty, over the pipeline's lifetime.
+		[[nodiscard]] auto batches_allocated() const -> std::uint64_t;
+
+		// Ready-made stages. None of them allocates once its buffers have grown to fit.
+		// Replaces v with unit(v); vectors with no unit vector are dropped.
+		static auto unit_stage() -> stage_function;
+		// Multiplies v by `coefficient`.
+		static auto scale_stage(double coefficient) -> stage_function;
+		// Replaces v with its projection; `rp` must outlive the pipeline. Works a micro-batch at a
+		// time, so each row of the matrix is generated once per batch.
+		static auto projection_stage(random_projection const& rp) -> batch_stage_function;
+		// Keeps only vectors whose euclidean_norm lies in [min_norm, max_norm].
+		static auto norm_filter_stage(double min_norm, double max_norm) -> stage_function;
+
+	private:
+		struct batch;
+		struct counters;
+
+		std::size_t batch_size_;
+		std::size_t queue_capacity_;
+		std::vector<std::string> names_;
+		// Stage s is stages_[s], or batch_stages_[s] when that is set.
+		std::vector<stage_function> stages_;
+		std::vector<batch_stage_function> batch_stages_;
+		std::vector<std::unique_ptr<counters>> counters_;
+		// Returned batches waiting to be refilled by the source.
+		std::unique_ptr<detail::spsc_queue<std::unique_ptr<batch>>> pool_;
+		std::atomic<std::uint64_t> batches_allocated_;
+		// Dimension of the last vector the source produced, to hand it matching buffers.
+		euclidean_vector::size_type source_dimension_;
+	};
+
+} // namespace comp6771
+#endif // COMP6771_VECTOR_PIPELINE_HPP
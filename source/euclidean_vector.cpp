@@ -2,7 +2,9 @@
 // SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
 //
 #include "comp6771/euclidean_vector.hpp"
+#include "comp6771/detail/reduction.hpp"
 #include <algorithm>
+#include <array>
 #include <cassert>
 #include <cmath>
 #include <cstddef>
@@ -15,11 +17,14 @@
 #include <numeric>
 #include <sstream>
 #include <stdexcept>
+#include <system_error>
+#include <thread>
 #include <vector>
 
 #define assertm(exp, msg) assert(((void)msg, exp))
 #define ULONG static_cast<size_t> // cast a number to unsigned long
 #define INT static_cast<int> // cast a number to int
+#define SIZE static_cast<euclidean_vector::size_type> // cast a number to size_type
 
 namespace comp6771 {
 
@@ -29,7 +34,7 @@ namespace comp6771 {
 	*/
 
 	// Constructor that makes a vector of size "dim" and all elements equal to "v"
-	euclidean_vector::euclidean_vector(int dim, double v) noexcept
+	euclidean_vector::euclidean_vector(size_type dim, double v) noexcept
 	: norm_{nullptr}
 	, dimension_{dim}
 	, magnitude_{// NOLINTNEXTLINE(modernize-avoid-c-arrays)
@@ -40,13 +45,13 @@ namespace comp6771 {
 	euclidean_vector::euclidean_vector() noexcept
 	: euclidean_vector(1, 0.0) {}
 	// Constructor with only one arguement
-	euclidean_vector::euclidean_vector(int dim) noexcept
+	euclidean_vector::euclidean_vector(size_type dim) noexcept
 	: euclidean_vector(dim, 0.0) {}
 	// Constructor with begin and end iterators
 	euclidean_vector::euclidean_vector(std::vector<double>::const_iterator begin,
 	                                   std::vector<double>::const_iterator end) noexcept
 	: norm_{nullptr}
-	, dimension_{INT(std::distance(begin, end))} {
+	, dimension_{SIZE(std::distance(begin, end))} {
 		// NOLINTNEXTLINE(modernize-avoid-c-arrays)
 		magnitude_ = std::make_unique<double[]>(ULONG(dimension_));
 		std::copy_n(begin, dimension_, magnitude_.get());
@@ -54,7 +59,7 @@ namespace comp6771 {
 	// Constructor with initializer_list
 	euclidean_vector::euclidean_vector(std::initializer_list<double> list) noexcept
 	: norm_{nullptr}
-	, dimension_{INT(list.size())}
+	, dimension_{SIZE(list.size())}
 	, magnitude_{// NOLINTNEXTLINE(modernize-avoid-c-arrays)
 	             std::make_unique<double[]>(ULONG(dimension_))} {
 		std::copy_n(list.begin(), dimension_, magnitude_.get());
@@ -117,14 +122,14 @@ namespace comp6771 {
 		return *this;
 	}
 	// Subscript Operator
-	auto euclidean_vector::operator[](int index) -> double& {
+	auto euclidean_vector::operator[](size_type index) -> double& {
 		assertm(index >= 0 && index < dimension_, "index out of range");
 		if (norm_) {
 			norm_ = nullptr;
 		}
 		return magnitude_[ULONG(index)];
 	}
-	auto euclidean_vector::operator[](int index) const -> const double& {
+	auto euclidean_vector::operator[](size_type index) const -> const double& {
 		assertm(index >= 0 && index < dimension_, "index out of range");
 		return magnitude_[ULONG(index)];
 	}
@@ -144,8 +149,8 @@ namespace comp6771 {
 	}
 	// Compound Addition
 	auto euclidean_vector::operator+=(euclidean_vector const& ev) -> euclidean_vector& {
-		int lhs = dimension_;
-		int rhs = ev.dimension_;
+		auto lhs = dimension_;
+		auto rhs = ev.dimension_;
 		if (lhs != rhs) {
 			std::stringstream buf;
 			buf << "Dimensions of LHS(" << lhs << ") "
@@ -164,8 +169,8 @@ namespace comp6771 {
 	}
 	// Compound Subtraction
 	auto euclidean_vector::operator-=(euclidean_vector const& ev) -> euclidean_vector& {
-		int lhs = dimension_;
-		int rhs = ev.dimension_;
+		auto lhs = dimension_;
+		auto rhs = ev.dimension_;
 		if (lhs != rhs) {
 			std::stringstream buf;
 			buf << "Dimensions of LHS(" << lhs << ") "
@@ -225,7 +230,7 @@ namespace comp6771 {
 		return l;
 	}
 	/*			Member Functions 		*/
-	auto euclidean_vector::at(int index) const -> double {
+	auto euclidean_vector::at(size_type index) const -> double {
 		if (index < 0 || index >= dimension_) {
 			std::stringstream buf;
 			buf << "Index " << index << " is not valid for this euclidean_vector object";
@@ -233,7 +238,7 @@ namespace comp6771 {
 		}
 		return magnitude_[ULONG(index)];
 	}
-	auto euclidean_vector::at(int index) -> double& {
+	auto euclidean_vector::at(size_type index) -> double& {
 		if (index < 0 || index >= dimension_) {
 			std::stringstream buf;
 			buf << "Index " << index << " is not valid for this euclidean_vector object";
@@ -245,7 +250,7 @@ namespace comp6771 {
 		return magnitude_[ULONG(index)];
 	}
 	// Dimension Function: returns dimension of a euclidean vector.
-	auto euclidean_vector::dimensions() const -> int {
+	auto euclidean_vector::dimensions() const -> size_type {
 		return dimension_;
 	}
 
@@ -360,6 +365,103 @@ namespace comp6771 {
 		return os;
 	}
 
+	// Swap
+	auto swap(euclidean_vector& ev1, euclidean_vector& ev2) noexcept -> void {
+		std::swap(ev1.norm_, ev2.norm_);
+		std::swap(ev1.dimension_, ev2.dimension_);
+		std::swap(ev1.magnitude_, ev2.magnitude_);
+	}
+
+	/* 			Reproducible Reduction 		*/
+	namespace {
+		// Like reduction_block, the lane count is part of the result; keep it fixed.
+		constexpr auto reduction_lanes = std::size_t{8};
+		// Smallest number of blocks worth handing to a thread of its own.
+		constexpr auto blocks_per_thread = std::size_t{16};
+
+		// Sums x[i] * y[i] over one block. Element i always goes to lane i % 8 and the lanes are
+		// combined in a fixed tree, so vectorising the inner loop cannot change the result.
+		auto block_dot(double const* x, double const* y, std::size_t n) -> double {
+			auto lane = std::array<double, reduction_lanes>{};
+			auto i = std::size_t{0};
+			for (; i + reduction_lanes <= n; i += reduction_lanes) {
+				for (auto j = std::size_t{0}; j < reduction_lanes; ++j) {
+					lane[j] += x[i + j] * y[i + j];
+				}
+			}
+			for (auto j = std::size_t{0}; i + j < n; ++j) {
+				lane[j] += x[i + j] * y[i + j];
+			}
+			return ((lane[0] + lane[1]) + (lane[2] + lane[3]))
+			       + ((lane[4] + lane[5]) + (lane[6] + lane[7]));
+		}
+
+		auto reproducible_dot(double const* x, double const* y, std::size_t n, int threads)
+		   -> double {
+			auto partial = std::vector<double>(detail::reduction_blocks(n));
+			detail::reduce_blocks(x, y, n, threads, partial.data());
+			return detail::pairwise_sum(partial.data(), partial.size());
+		}
+	} // namespace
+
+	auto detail::for_each_block_range(
+	   std::size_t blocks,
+	   int threads,
+	   std::function<void(std::size_t first, std::size_t last)> const& f) -> void {
+		if (threads <= 0) {
+			threads = std::max(INT(std::thread::hardware_concurrency()), 1);
+		}
+		// Workers only decide who handles which blocks, never how block results are combined.
+		auto const workers =
+		   std::max(std::min(ULONG(threads), blocks / blocks_per_thread), std::size_t{1});
+		// jthreads join on destruction, so started workers are joined even while unwinding.
+		auto pool = std::vector<std::jthread>();
+		pool.reserve(workers - 1);
+		auto const share = blocks / workers;
+		auto const extra = blocks % workers;
+		auto first = std::size_t{0};
+		for (auto w = std::size_t{0}; w < workers; ++w) {
+			auto const last = first + share + (w < extra ? 1 : 0);
+			if (w + 1 == workers) {
+				f(first, last);
+			}
+			else {
+				try {
+					pool.emplace_back(f, first, last);
+				} catch (std::system_error const&) {
+					// No thread to spare: handle this range here instead. The result is unchanged.
+					f(first, last);
+				}
+			}
+			first = last;
+		}
+	}
+
+	auto detail::reduce_blocks(double const* x,
+	                           double const* y,
+	                           std::size_t n,
+	                           int threads,
+	                           double* partial) -> void {
+		for_each_block_range(reduction_blocks(n), threads, [=](std::size_t first, std::size_t last) {
+			for (auto b = first; b < last; ++b) {
+				auto const offset = b * reduction_block;
+				partial[b] =
+				   block_dot(x + offset, y + offset, std::min(reduction_block, n - offset));
+			}
+		});
+	}
+
+	auto detail::pairwise_sum(double const* p, std::size_t n) noexcept -> double {
+		if (n == 0) {
+			return 0;
+		}
+		if (n == 1) {
+			return p[0];
+		}
+		auto const half = n / 2;
+		return pairwise_sum(p, half) + pairwise_sum(p + half, n - half);
+	}
+
 	/* 			Utility Function 		*/
 
 	// Norm
@@ -378,6 +480,20 @@ namespace comp6771 {
 		v.norm_ = std::make_unique<double>(norm1);
 		return norm1;
 	}
+	// Norm with an explicit reduction mode. Only the sequential result is cached.
+	auto euclidean_norm(euclidean_vector const& v, reduction mode) -> double {
+		return euclidean_norm(v, mode, 0);
+	}
+	auto euclidean_norm(euclidean_vector const& v, reduction mode, int threads) -> double {
+		if (mode == reduction::sequential) {
+			return euclidean_norm(v);
+		}
+		if (v.dimensions() == 0) {
+			return 0;
+		}
+		return std::sqrt(
+		   reproducible_dot(v.magnitude_.get(), v.magnitude_.get(), ULONG(v.dimension_), threads));
+	}
 	// Unit: returns a Euclidean vector that is the unit vector of v.
 	auto unit(euclidean_vector const& v) -> euclidean_vector {
 		if (v.dimensions() == 0) {
@@ -408,5 +524,22 @@ namespace comp6771 {
 		                                0.0);
 		return sum;
 	}
+	// Dot with an explicit reduction mode; threads <= 0 uses every hardware thread.
+	auto dot(euclidean_vector const& x, euclidean_vector const& y, reduction mode) -> double {
+		return dot(x, y, mode, 0);
+	}
+	auto dot(euclidean_vector const& x, euclidean_vector const& y, reduction mode, int threads)
+	   -> double {
+		if (mode == reduction::sequential) {
+			return dot(x, y);
+		}
+		if (x.dimensions() != y.dimensions()) {
+			std::stringstream buf;
+			buf << "Dimensions of LHS(" << x.dimensions() << ") "
+			    << "and RHS(" << y.dimensions() << ") do not match";
+			throw euclidean_vector_error(buf.str());
+		}
+		return reproducible_dot(x.magnitude_.get(), y.magnitude_.get(), ULONG(x.dimension_), threads);
+	}
 
 } // namespace comp6771
@@ -0,0 +1,522 @@
+// Copyright (c) Christopher Di Bella.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+#include "comp6771/mapped_euclidean_vector.hpp"
+#include "comp6771/detail/reduction.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <functional>
+#include <initializer_list>
+#include <numeric>
+#include <sstream>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+#define assertm(exp, msg) assert(((void)msg, exp))
+#define ULONG static_cast<size_t> // cast a number to unsigned long
+#define SIZE static_cast<mapped_euclidean_vector::size_type> // cast a number to size_type
+
+namespace comp6771 {
+
+	namespace {
+		// Magnitudes processed per step of a streaming operation (8 MiB). A multiple of
+		// detail::reduction_block, so chunk boundaries never split a reduction block.
+		constexpr auto chunk_size = std::size_t{1} << 20U;
+		static_assert(chunk_size % detail::reduction_block == 0);
+
+		[[noreturn]] auto throw_errno(std::string const& what) -> void {
+			throw euclidean_vector_error(what + ": " + std::strerror(errno));
+		}
+
+		auto check_dimensions(mapped_euclidean_vector::size_type lhs,
+		                      mapped_euclidean_vector::size_type rhs) -> void {
+			if (lhs != rhs) {
+				std::stringstream buf;
+				buf << "Dimensions of LHS(" << lhs << ") "
+				    << "and RHS(" << rhs << ") do not match";
+				throw euclidean_vector_error(buf.str());
+			}
+		}
+
+		// Asks the kernel to start reading [p, p + count) in the background.
+		auto will_need(double const* p, std::size_t count) -> void {
+			static auto const page = ULONG(::sysconf(_SC_PAGESIZE));
+			auto const begin = reinterpret_cast<std::uintptr_t>(p) & ~(page - 1);
+			auto const end = reinterpret_cast<std::uintptr_t>(p + count);
+			// Only a hint: failure just means no read-ahead.
+			::madvise(reinterpret_cast<void*>(begin), end - begin, MADV_WILLNEED);
+		}
+
+		// Calls f(first, count) for each chunk of [begin, n) in order, after requesting read-ahead
+		// of the following chunk of every source.
+		template<typename F>
+		auto for_each_chunk(std::size_t begin,
+		                    std::size_t n,
+		                    std::initializer_list<double const*> sources,
+		                    F f) -> void {
+			for (auto first = begin; first < n; first += chunk_size) {
+				auto const count = std::min(chunk_size, n - first);
+				auto const next = first + count;
+				if (next < n) {
+					for (auto const* source : sources) {
+						will_need(source + next, std::min(chunk_size, n - next));
+					}
+				}
+				f(first, count);
+			}
+		}
+		template<typename F>
+		auto for_each_chunk(std::size_t n, std::initializer_list<double const*> sources, F f)
+		   -> void {
+			for_each_chunk(0, n, sources, std::move(f));
+		}
+
+		auto parent_directory(std::string const& path) -> std::string {
+			auto const slash = path.find_last_of('/');
+			if (slash == std::string::npos) {
+				return ".";
+			}
+			return slash == 0 ? "/" : path.substr(0, slash);
+		}
+	} // namespace
+
+	/*	          Constructor Section		*/
+
+	mapped_euclidean_vector::mapped_euclidean_vector(std::string path,
+	                                                 std::string directory,
+	                                                 int fd,
+	                                                 size_type dim,
+	                                                 access mode)
+	: path_{std::move(path)}
+	, directory_{std::move(directory)}
+	, fd_{fd}
+	, dimension_{dim}
+	, magnitude_{nullptr}
+	, writable_{mode == access::read_write} {
+		if (dimension_ == 0) {
+			return;
+		}
+		auto* const map = ::mmap(nullptr,
+		                         ULONG(dimension_) * sizeof(double),
+		                         writable_ ? PROT_READ | PROT_WRITE : PROT_READ,
+		                         MAP_SHARED,
+		                         fd_,
+		                         0);
+		if (map == MAP_FAILED) {
+			auto const error = errno;
+			::close(fd_);
+			errno = error;
+			throw_errno("Cannot map " + (path_.empty() ? "temporary file" : path_));
+		}
+		magnitude_ = static_cast<double*>(map);
+	}
+	// Create: a new file holding dim magnitudes equal to v
+	auto mapped_euclidean_vector::create(std::string const& path, size_type dim, double v)
+	   -> mapped_euclidean_vector {
+		if (dim < 0) {
+			throw euclidean_vector_error("Cannot create a mapped_euclidean_vector with negative "
+			                             "dimension");
+		}
+		auto const fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+		if (fd < 0) {
+			throw_errno("Cannot create " + path);
+		}
+		if (::ftruncate(fd, static_cast<off_t>(ULONG(dim) * sizeof(double))) != 0) {
+			auto const error = errno;
+			::close(fd);
+			errno = error;
+			throw_errno("Cannot resize " + path);
+		}
+		auto res = mapped_euclidean_vector(path, parent_directory(path), fd, dim);
+		// The file is already all zeros; writing them would only allocate disk blocks.
+		if (v != 0.0) {
+			for_each_chunk(ULONG(dim), {}, [&](std::size_t first, std::size_t count) {
+				std::fill_n(res.magnitude_ + first, count, v);
+			});
+		}
+		return res;
+	}
+	// Open: maps an existing file of raw doubles
+	auto mapped_euclidean_vector::open(std::string const& path, access mode)
+	   -> mapped_euclidean_vector {
+		auto const fd = ::open(path.c_str(), mode == access::read_write ? O_RDWR : O_RDONLY);
+		if (fd < 0) {
+			throw_errno("Cannot open " + path);
+		}
+		struct stat info {};
+		if (::fstat(fd, &info) != 0) {
+			auto const error = errno;
+			::close(fd);
+			errno = error;
+			throw_errno("Cannot stat " + path);
+		}
+		if (ULONG(info.st_size) % sizeof(double) != 0) {
+			::close(fd);
+			throw euclidean_vector_error(path + " does not hold a whole number of doubles");
+		}
+		return mapped_euclidean_vector(path,
+		                               parent_directory(path),
+		                               fd,
+		                               SIZE(ULONG(info.st_size) / sizeof(double)),
+		                               mode);
+	}
+	// Temporary: an unnamed file that disappears once unmapped
+	auto mapped_euclidean_vector::temporary(mapped_euclidean_vector const& ev, size_type dim)
+	   -> mapped_euclidean_vector {
+		auto name = ev.directory_ + "/.euclidean_vector.XXXXXX";
+		auto const fd = ::mkstemp(name.data());
+		if (fd < 0) {
+			throw_errno("Cannot create a temporary file in " + ev.directory_);
+		}
+		::unlink(name.c_str());
+		if (::ftruncate(fd, static_cast<off_t>(ULONG(dim) * sizeof(double))) != 0) {
+			auto const error = errno;
+			::close(fd);
+			errno = error;
+			throw_errno("Cannot resize a temporary file in " + ev.directory_);
+		}
+		return mapped_euclidean_vector("", ev.directory_, fd, dim);
+	}
+	// Move Constructor
+	mapped_euclidean_vector::mapped_euclidean_vector(mapped_euclidean_vector&& ev) noexcept
+	: path_{std::move(ev.path_)}
+	, directory_{std::move(ev.directory_)}
+	, fd_{std::exchange(ev.fd_, -1)}
+	, dimension_{std::exchange(ev.dimension_, 0)}
+	, magnitude_{std::exchange(ev.magnitude_, nullptr)}
+	, writable_{ev.writable_} {}
+	// Destructor: unmapping writes nothing back synchronously; the kernel flushes dirty pages.
+	mapped_euclidean_vector::~mapped_euclidean_vector() {
+		if (magnitude_ != nullptr) {
+			::munmap(magnitude_, ULONG(dimension_) * sizeof(double));
+		}
+		if (fd_ >= 0) {
+			::close(fd_);
+		}
+	}
+
+	/* 				Operator Section		*/
+
+	// Move Assignment
+	auto mapped_euclidean_vector::operator=(mapped_euclidean_vector&& ev) noexcept
+	   -> mapped_euclidean_vector& {
+		if (this != &ev) {
+			auto old = std::move(*this);
+			path_ = std::move(ev.path_);
+			directory_ = std::move(ev.directory_);
+			fd_ = std::exchange(ev.fd_, -1);
+			dimension_ = std::exchange(ev.dimension_, 0);
+			magnitude_ = std::exchange(ev.magnitude_, nullptr);
+			writable_ = ev.writable_;
+		}
+		return *this;
+	}
+	// Subscript Operator
+	auto mapped_euclidean_vector::operator[](size_type index) -> double& {
+		assertm(index >= 0 && index < dimension_, "index out of range");
+		check_writable();
+		return magnitude_[ULONG(index)];
+	}
+	auto mapped_euclidean_vector::operator[](size_type index) const -> const double& {
+		assertm(index >= 0 && index < dimension_, "index out of range");
+		return magnitude_[ULONG(index)];
+	}
+	// Unary Plus: a temporary copy
+	auto mapped_euclidean_vector::operator+() const -> mapped_euclidean_vector {
+		auto res = temporary(*this, dimension_);
+		for_each_chunk(ULONG(dimension_), {magnitude_}, [&](std::size_t first, std::size_t count) {
+			std::copy_n(magnitude_ + first, count, res.magnitude_ + first);
+		});
+		return res;
+	}
+	// Negation
+	auto mapped_euclidean_vector::operator-() const -> mapped_euclidean_vector {
+		auto res = temporary(*this, dimension_);
+		for_each_chunk(ULONG(dimension_), {magnitude_}, [&](std::size_t first, std::size_t count) {
+			std::transform(magnitude_ + first,
+			               magnitude_ + first + count,
+			               res.magnitude_ + first,
+			               std::negate());
+		});
+		return res;
+	}
+	// Compound Addition
+	auto mapped_euclidean_vector::operator+=(mapped_euclidean_vector const& ev)
+	   -> mapped_euclidean_vector& {
+		check_writable();
+		check_dimensions(dimension_, ev.dimension_);
+		for_each_chunk(ULONG(dimension_),
+		               {magnitude_, ev.magnitude_},
+		               [&](std::size_t first, std::size_t count) {
+			               std::transform(magnitude_ + first,
+			                              magnitude_ + first + count,
+			                              ev.magnitude_ + first,
+			                              magnitude_ + first,
+			                              std::plus<>{});
+		               });
+		return *this;
+	}
+	// Compound Subtraction
+	auto mapped_euclidean_vector::operator-=(mapped_euclidean_vector const& ev)
+	   -> mapped_euclidean_vector& {
+		check_writable();
+		check_dimensions(dimension_, ev.dimension_);
+		for_each_chunk(ULONG(dimension_),
+		               {magnitude_, ev.magnitude_},
+		               [&](std::size_t first, std::size_t count) {
+			               std::transform(magnitude_ + first,
+			                              magnitude_ + first + count,
+			                              ev.magnitude_ + first,
+			                              magnitude_ + first,
+			                              std::minus<>{});
+		               });
+		return *this;
+	}
+	// Compound Multiplication
+	auto mapped_euclidean_vector::operator*=(double coefficient) -> mapped_euclidean_vector& {
+		check_writable();
+		if (coefficient == 1) {
+			return *this;
+		}
+		for_each_chunk(ULONG(dimension_), {magnitude_}, [&](std::size_t first, std::size_t count) {
+			std::transform(magnitude_ + first,
+			               magnitude_ + first + count,
+			               magnitude_ + first,
+			               [&coefficient](double x) { return coefficient * x; });
+		});
+		return *this;
+	}
+	// Compound Division
+	auto mapped_euclidean_vector::operator/=(double divisor) -> mapped_euclidean_vector& {
+		check_writable();
+		if (divisor == 0) {
+			throw euclidean_vector_error("Invalid vector division by 0");
+		}
+		if (divisor == 1) {
+			return *this;
+		}
+		for_each_chunk(ULONG(dimension_), {magnitude_}, [&](std::size_t first, std::size_t count) {
+			std::transform(magnitude_ + first,
+			               magnitude_ + first + count,
+			               magnitude_ + first,
+			               [&divisor](double x) { return x / divisor; });
+		});
+		return *this;
+	}
+	// euclidean_vector Type Conversion: loads the whole vector into memory
+	mapped_euclidean_vector::operator euclidean_vector() const {
+		auto res = euclidean_vector(dimension_);
+		if (dimension_ == 0) {
+			return res;
+		}
+		auto* const out = &res[0];
+		for_each_chunk(ULONG(dimension_), {magnitude_}, [&](std::size_t first, std::size_t count) {
+			std::copy_n(magnitude_ + first, count, out + first);
+		});
+		return res;
+	}
+
+	/*			Member Functions 		*/
+	auto mapped_euclidean_vector::at(size_type index) const -> double {
+		if (index < 0 || index >= dimension_) {
+			std::stringstream buf;
+			buf << "Index " << index << " is not valid for this mapped_euclidean_vector object";
+			throw euclidean_vector_error(buf.str());
+		}
+		return magnitude_[ULONG(index)];
+	}
+	auto mapped_euclidean_vector::at(size_type index) -> double& {
+		if (index < 0 || index >= dimension_) {
+			std::stringstream buf;
+			buf << "Index " << index << " is not valid for this mapped_euclidean_vector object";
+			throw euclidean_vector_error(buf.str());
+		}
+		check_writable();
+		return magnitude_[ULONG(index)];
+	}
+	auto mapped_euclidean_vector::dimensions() const -> size_type {
+		return dimension_;
+	}
+	auto mapped_euclidean_vector::writable() const -> bool {
+		return writable_;
+	}
+	auto mapped_euclidean_vector::path() const -> std::string const& {
+		return path_;
+	}
+	auto mapped_euclidean_vector::flush() -> void {
+		if (magnitude_ != nullptr
+		    && ::msync(magnitude_, ULONG(dimension_) * sizeof(double), MS_SYNC) != 0) {
+			throw_errno("Cannot flush " + (path_.empty() ? "temporary file" : path_));
+		}
+	}
+
+	/*			Private Functions 		*/
+
+	auto mapped_euclidean_vector::check_writable() const -> void {
+		if (!writable_) {
+			throw euclidean_vector_error(path_ + " is mapped read-only");
+		}
+	}
+
+	/* 			Friend Functions        */
+	// Equal
+	auto operator==(mapped_euclidean_vector const& ev1, mapped_euclidean_vector const& ev2) -> bool {
+		if (ev1.dimension_ != ev2.dimension_) {
+			return false;
+		}
+		auto const n = ULONG(ev1.dimension_);
+		for (auto first = std::size_t{0}; first < n; first += chunk_size) {
+			auto const count = std::min(chunk_size, n - first);
+			if (first + count < n) {
+				will_need(ev1.magnitude_ + first + count, std::min(chunk_size, n - first - count));
+				will_need(ev2.magnitude_ + first + count, std::min(chunk_size, n - first - count));
+			}
+			if (!std::equal(ev1.magnitude_ + first,
+			                ev1.magnitude_ + first + count,
+			                ev2.magnitude_ + first)) {
+				return false;
+			}
+		}
+		return true;
+	}
+	// Not Equal
+	auto operator!=(mapped_euclidean_vector const& ev1, mapped_euclidean_vector const& ev2) -> bool {
+		return !(ev1 == ev2);
+	}
+	// Addition
+	auto operator+(mapped_euclidean_vector const& ev1, mapped_euclidean_vector const& ev2)
+	   -> mapped_euclidean_vector {
+		check_dimensions(ev1.dimension_, ev2.dimension_);
+		auto res = mapped_euclidean_vector::temporary(ev1, ev1.dimension_);
+		for_each_chunk(ULONG(ev1.dimension_),
+		               {ev1.magnitude_, ev2.magnitude_},
+		               [&](std::size_t first, std::size_t count) {
+			               std::transform(ev1.magnitude_ + first,
+			                              ev1.magnitude_ + first + count,
+			                              ev2.magnitude_ + first,
+			                              res.magnitude_ + first,
+			                              std::plus<>{});
+		               });
+		return res;
+	}
+	// Substraction
+	auto operator-(mapped_euclidean_vector const& ev1, mapped_euclidean_vector const& ev2)
+	   -> mapped_euclidean_vector {
+		check_dimensions(ev1.dimension_, ev2.dimension_);
+		auto res = mapped_euclidean_vector::temporary(ev1, ev1.dimension_);
+		for_each_chunk(ULONG(ev1.dimension_),
+		               {ev1.magnitude_, ev2.magnitude_},
+		               [&](std::size_t first, std::size_t count) {
+			               std::transform(ev1.magnitude_ + first,
+			                              ev1.magnitude_ + first + count,
+			                              ev2.magnitude_ + first,
+			                              res.magnitude_ + first,
+			                              std::minus<>{});
+		               });
+		return res;
+	}
+	// Multiply
+	auto operator*(mapped_euclidean_vector const& ev, double coef) -> mapped_euclidean_vector {
+		if (coef == 1) {
+			return +ev;
+		}
+		auto res = mapped_euclidean_vector::temporary(ev, ev.dimension_);
+		for_each_chunk(ULONG(ev.dimension_),
+		               {ev.magnitude_},
+		               [&](std::size_t first, std::size_t count) {
+			               std::transform(ev.magnitude_ + first,
+			                              ev.magnitude_ + first + count,
+			                              res.magnitude_ + first,
+			                              [&coef](double x) { return coef * x; });
+		               });
+		return res;
+	}
+	auto operator*(double coef, mapped_euclidean_vector const& ev) -> mapped_euclidean_vector {
+		return ev * coef;
+	}
+	// Divide
+	auto operator/(mapped_euclidean_vector const& ev, double divisor) -> mapped_euclidean_vector {
+		if (divisor == 0) {
+			throw euclidean_vector_error("Invalid vector division by 0");
+		}
+		if (divisor == 1) {
+			return +ev;
+		}
+		auto res = mapped_euclidean_vector::temporary(ev, ev.dimension_);
+		for_each_chunk(ULONG(ev.dimension_),
+		               {ev.magnitude_},
+		               [&](std::size_t first, std::size_t count) {
+			               std::transform(ev.magnitude_ + first,
+			                              ev.magnitude_ + first + count,
+			                              res.magnitude_ + first,
+			                              [&divisor](double x) { return x / divisor; });
+		               });
+		return res;
+	}
+
+	/* 			Utility Function 		*/
+
+	// Norm
+	auto euclidean_norm(mapped_euclidean_vector const& v) -> double {
+		return euclidean_norm(v, reduction::reproducible);
+	}
+	auto euclidean_norm(mapped_euclidean_vector const& v, reduction mode) -> double {
+		return euclidean_norm(v, mode, 0);
+	}
+	auto euclidean_norm(mapped_euclidean_vector const& v, reduction mode, int threads) -> double {
+		return std::sqrt(dot(v, v, mode, threads));
+	}
+	// Dot: streams both files once, block results are combined exactly as for euclidean_vector
+	auto dot(mapped_euclidean_vector const& x, mapped_euclidean_vector const& y) -> double {
+		return dot(x, y, reduction::reproducible);
+	}
+	// Dot with an explicit reduction mode; threads <= 0 uses every hardware thread.
+	auto dot(mapped_euclidean_vector const& x, mapped_euclidean_vector const& y, reduction mode)
+	   -> double {
+		return dot(x, y, mode, 0);
+	}
+	auto dot(mapped_euclidean_vector const& x,
+	         mapped_euclidean_vector const& y,
+	         reduction mode,
+	         int threads) -> double {
+		check_dimensions(x.dimension_, y.dimension_);
+		auto const n = ULONG(x.dimension_);
+		if (mode == reduction::sequential) {
+			auto sum = 0.0;
+			for_each_chunk(n, {x.magnitude_, y.magnitude_}, [&](std::size_t first, std::size_t count) {
+				sum = std::inner_product(x.magnitude_ + first,
+				                         x.magnitude_ + first + count,
+				                         y.magnitude_ + first,
+				                         sum);
+			});
+			return sum;
+		}
+		// The blocks are split across workers once; each streams its own contiguous range with
+		// read-ahead. Every block still lands in its own slot, so the bits do not change.
+		auto partial = std::vector<double>(detail::reduction_blocks(n));
+		detail::for_each_block_range(partial.size(), threads, [&](std::size_t first, std::size_t last) {
+			for_each_chunk(first * detail::reduction_block,
+			               std::min(last * detail::reduction_block, n),
+			               {x.magnitude_, y.magnitude_},
+			               [&](std::size_t offset, std::size_t count) {
+				               detail::reduce_blocks(x.magnitude_ + offset,
+				                                     y.magnitude_ + offset,
+				                                     count,
+				                                     1,
+				                                     partial.data() + offset / detail::reduction_block);
+			               });
+		});
+		return detail::pairwise_sum(partial.data(), partial.size());
+	}
+
+} // namespace comp6771
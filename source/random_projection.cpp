@@ -0,0 +1,333 @@
+// Copyright (c) Christopher Di Bella.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+#include "comp6771/random_projection.hpp"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <numbers>
+#include <sstream>
+#include <utility>
+#include <vector>
+
+#define ULONG static_cast<size_t> // cast a number to unsigned long
+#define SIZE static_cast<random_projection::size_type> // cast a number to size_type
+
+namespace comp6771 {
+
+	namespace {
+		constexpr auto golden_gamma = std::uint64_t{0x9E3779B97F4A7C15};
+
+		// SplitMix64 finaliser: a counter-based generator, so any entry can be regenerated
+		// without replaying the ones before it.
+		constexpr auto mix(std::uint64_t z) noexcept -> std::uint64_t {
+			z = (z ^ (z >> 30U)) * std::uint64_t{0xBF58476D1CE4E5B9};
+			z = (z ^ (z >> 27U)) * std::uint64_t{0x94D049BB133111EB};
+			return z ^ (z >> 31U);
+		}
+		auto row_key(std::uint64_t seed, random_projection::size_type row) noexcept
+		   -> std::uint64_t {
+			return mix(seed + golden_gamma * (static_cast<std::uint64_t>(row) + 1));
+		}
+		auto word(std::uint64_t key, std::uint64_t counter) noexcept -> std::uint64_t {
+			return mix(key + golden_gamma * (counter + 1));
+		}
+
+		// Achlioptas entries take 16 bits each, four to a word. The 1/6 thresholds are exact to
+		// within 2^-16.
+		constexpr auto sixth = std::uint64_t{65536 / 6};
+		auto achlioptas_sign(std::uint64_t key, random_projection::size_type column) noexcept
+		   -> int {
+			auto const c = static_cast<std::uint64_t>(column);
+			auto const bits = (word(key, c / 4) >> (16 * (c % 4))) & 0xFFFFU;
+			if (bits < sixth) {
+				return 1;
+			}
+			return bits < 2 * sixth ? -1 : 0;
+		}
+
+		// Gaussian entries come in Box-Muller pairs, one word per pair of columns.
+		auto gaussian_pair(std::uint64_t key, std::uint64_t pair) noexcept
+		   -> std::pair<double, double> {
+			auto const w = word(key, pair);
+			auto const u1 = (static_cast<double>(w >> 32U) + 0.5) / 4294967296.0;
+			auto const u2 = (static_cast<double>(w & 0xFFFFFFFFU) + 0.5) / 4294967296.0;
+			auto const radius = std::sqrt(-2 * std::log(u1));
+			auto const angle = 2 * std::numbers::pi * u2;
+			return {radius * std::cos(angle), radius * std::sin(angle)};
+		}
+
+		// A row is summed in four interleaved lanes (column c goes to lane c % 4), combined as
+		// (lane 0 + lane 1) + (lane 2 + lane 3). The lanes hide the latency of the additions, and
+		// the fixed order gives single and batch projections the same bits.
+		constexpr auto row_lanes = std::size_t{4};
+		auto combine(double const (&lane)[row_lanes]) noexcept -> double {
+			return (lane[0] + lane[1]) + (lane[2] + lane[3]);
+		}
+
+		// The 16-bit Achlioptas code in the low bits of `code` as +1, -1 or 0. The codes are
+		// random, so the sign and the zero are masked into the bits of 1.0 rather than branched on.
+		auto sign_of(std::uint64_t code) noexcept -> double {
+			auto const bits = code & 0xFFFFU;
+			auto const negate = static_cast<std::uint64_t>(bits >= sixth) << 63U;
+			auto const keep = std::uint64_t{0} - static_cast<std::uint64_t>(bits < 2 * sixth);
+			return std::bit_cast<double>((std::bit_cast<std::uint64_t>(1.0) ^ negate) & keep);
+		}
+
+		// Sum of sign(c) * x[c] over one Achlioptas row of d columns, decoding the codes straight
+		// into the sum; codes(q) returns the word holding the codes of columns [4q, 4q + 4).
+		template<typename Codes>
+		auto achlioptas_row(Codes const& codes, double const* x, std::size_t d) noexcept -> double {
+			double lane[row_lanes] = {};
+			auto const words = d / row_lanes;
+			for (auto q = std::size_t{0}; q < words; ++q) {
+				auto const w = codes(q);
+				auto const* const xs = x + row_lanes * q;
+				for (auto l = std::size_t{0}; l < row_lanes; ++l) {
+					lane[l] += sign_of(w >> (16 * l)) * xs[l];
+				}
+			}
+			if (auto const rest = d % row_lanes; rest != 0) {
+				auto const w = codes(words);
+				for (auto l = std::size_t{0}; l < rest; ++l) {
+					lane[l] += sign_of(w >> (16 * l)) * x[row_lanes * words + l];
+				}
+			}
+			return combine(lane);
+		}
+		// Sum of e(c) * x[c] over one Gaussian row of d columns; pair(p) returns the scaled entries
+		// of columns 2p and 2p + 1.
+		template<typename Pairs>
+		auto gaussian_row(Pairs const& pair, double const* x, std::size_t d) noexcept -> double {
+			double lane[row_lanes] = {};
+			for (auto j = std::size_t{0}; j < d; j += 2) {
+				auto const [even, odd] = pair(j / 2);
+				lane[j % row_lanes] += even * x[j];
+				if (j + 1 < d) {
+					lane[(j + 1) % row_lanes] += odd * x[j + 1];
+				}
+			}
+			return combine(lane);
+		}
+
+		// Decodes a whole Achlioptas row into signs, hashing once per four columns.
+		auto generate_signs(std::uint64_t key, std::vector<double>& row) noexcept -> void {
+			for (auto j = std::size_t{0}; j < row.size(); j += row_lanes) {
+				auto w = word(key, j / row_lanes);
+				for (auto c = j; c < std::min(j + row_lanes, row.size()); ++c, w >>= 16U) {
+					row[c] = sign_of(w);
+				}
+			}
+		}
+		// Generates a whole Gaussian row, scaled.
+		auto generate_gaussian(std::uint64_t key, double scale, std::vector<double>& row) -> void {
+			for (auto j = std::size_t{0}; j < row.size(); j += 2) {
+				auto const [even, odd] = gaussian_pair(key, j / 2);
+				row[j] = scale * even;
+				if (j + 1 < row.size()) {
+					row[j + 1] = scale * odd;
+				}
+			}
+		}
+
+		// Sums of row[c] * x[n][c] for Count inputs at once, so that each entry of a generated row
+		// is loaded once for all of them. Every input keeps its own lanes, so its sum has the same
+		// bits as achlioptas_row and gaussian_row.
+		template<std::size_t Count>
+		auto dense_rows(std::vector<double> const& row, double const* const* x, double* sums) noexcept
+		   -> void {
+			double lane[Count][row_lanes] = {};
+			auto const d = row.size();
+			auto const full = d - d % row_lanes;
+			for (auto j = std::size_t{0}; j < full; j += row_lanes) {
+				for (auto n = std::size_t{0}; n < Count; ++n) {
+					for (auto l = std::size_t{0}; l < row_lanes; ++l) {
+						lane[n][l] += row[j + l] * x[n][j + l];
+					}
+				}
+			}
+			for (auto n = std::size_t{0}; n < Count; ++n) {
+				for (auto j = full; j < d; ++j) {
+					lane[n][j - full] += row[j] * x[n][j];
+				}
+				sums[n] = combine(lane[n]);
+			}
+		}
+		constexpr auto row_inputs = std::size_t{4};
+	} // namespace
+
+	/*	          Constructor Section		*/
+
+	random_projection::random_projection(size_type input_dim,
+	                                     size_type output_dim,
+	                                     std::uint64_t seed,
+	                                     distribution dist)
+	: input_dimension_{input_dim}
+	, output_dimension_{output_dim}
+	, seed_{seed}
+	, distribution_{dist}
+	, scale_{0} {
+		if (input_dim <= 0 || output_dim <= 0) {
+			throw euclidean_vector_error("random_projection dimensions must be positive");
+		}
+		auto const k = static_cast<double>(output_dim);
+		scale_ = dist == distribution::achlioptas ? std::sqrt(3 / k) : 1 / std::sqrt(k);
+	}
+
+	/* 				Operator Section		*/
+
+	auto random_projection::operator()(euclidean_vector const& v) const -> euclidean_vector {
+		auto res = euclidean_vector(output_dimension_);
+		project_into(v, res);
+		return res;
+	}
+	auto random_projection::operator()(std::vector<euclidean_vector> const& batch) const
+	   -> std::vector<euclidean_vector> {
+		auto res = std::vector<euclidean_vector>(batch.size(), euclidean_vector(output_dimension_));
+		auto in = std::vector<euclidean_vector const*>();
+		auto out = std::vector<euclidean_vector*>();
+		in.reserve(batch.size());
+		out.reserve(batch.size());
+		for (auto i = std::size_t{0}; i < batch.size(); ++i) {
+			in.push_back(&batch[i]);
+			out.push_back(&res[i]);
+		}
+		auto ws = workspace();
+		project_into(in, out, ws);
+		return res;
+	}
+
+	/*			Member Functions 		*/
+
+	auto random_projection::project_into(euclidean_vector const& v, euclidean_vector& out) const
+	   -> void {
+		if (&v == &out) {
+			out = (*this)(v);
+			return;
+		}
+		if (v.dimensions() != input_dimension_) {
+			std::stringstream buf;
+			buf << "Dimensions of euclidean_vector(" << v.dimensions() << ") "
+			    << "and random_projection input(" << input_dimension_ << ") do not match";
+			throw euclidean_vector_error(buf.str());
+		}
+		if (out.dimensions() != output_dimension_) {
+			out = euclidean_vector(output_dimension_);
+		}
+		project_one(&v[0], out);
+	}
+	auto random_projection::entry(size_type row, size_type column) const -> double {
+		if (row < 0 || row >= output_dimension_ || column < 0 || column >= input_dimension_) {
+			std::stringstream buf;
+			buf << "Entry (" << row << ", " << column << ") is not valid for this "
+			    << "random_projection object";
+			throw euclidean_vector_error(buf.str());
+		}
+		auto const key = row_key(seed_, row);
+		if (distribution_ == distribution::achlioptas) {
+			return scale_ * achlioptas_sign(key, column);
+		}
+		auto const [even, odd] = gaussian_pair(key, static_cast<std::uint64_t>(column) / 2);
+		return scale_ * (column % 2 == 0 ? even : odd);
+	}
+	auto random_projection::input_dimensions() const -> size_type {
+		return input_dimension_;
+	}
+	auto random_projection::output_dimensions() const -> size_type {
+		return output_dimension_;
+	}
+	auto random_projection::seed() const -> std::uint64_t {
+		return seed_;
+	}
+	auto random_projection::kind() const -> distribution {
+		return distribution_;
+	}
+	// k >= 4 ln(n) / (epsilon^2 / 2 - epsilon^3 / 3), after Dasgupta and Gupta.
+	auto random_projection::jl_dimension(size_type points, double epsilon) -> size_type {
+		if (epsilon <= 0 || epsilon >= 1) {
+			throw euclidean_vector_error("Johnson-Lindenstrauss epsilon must be in (0, 1)");
+		}
+		if (points < 2) {
+			return 1;
+		}
+		auto const bound = 4 * std::log(static_cast<double>(points))
+		                   / (epsilon * epsilon / 2 - epsilon * epsilon * epsilon / 3);
+		return SIZE(std::ceil(bound));
+	}
+
+	/*			Private Functions 		*/
+
+	auto random_projection::project_one(double const* x, euclidean_vector& out) const -> void {
+		auto const d = ULONG(input_dimension_);
+		for (auto i = size_type{0}; i < output_dimension_; ++i) {
+			auto const key = row_key(seed_, i);
+			if (distribution_ == distribution::achlioptas) {
+				out[i] = scale_ * achlioptas_row([key](std::size_t q) { return word(key, q); }, x, d);
+			}
+			else {
+				out[i] = gaussian_row(
+				   [this, key](std::size_t p) {
+					   auto const [even, odd] = gaussian_pair(key, p);
+					   return std::pair(scale_ * even, scale_ * odd);
+				   },
+				   x,
+				   d);
+			}
+		}
+	}
+	// Generates one row at a time and applies it to every input, so memory stays O(d) and a
+	// batch pays for generation once.
+	auto random_projection::project_into(std::vector<euclidean_vector const*> const& in,
+	                                     std::vector<euclidean_vector*> const& out,
+	                                     workspace& ws) const -> void {
+		if (in.size() != out.size()) {
+			std::stringstream buf;
+			buf << "Batch of " << in.size() << " inputs and " << out.size() << " outputs do not match";
+			throw euclidean_vector_error(buf.str());
+		}
+		auto& data = ws.inputs_;
+		data.clear();
+		for (auto const* v : in) {
+			if (v->dimensions() != input_dimension_) {
+				std::stringstream buf;
+				buf << "Dimensions of euclidean_vector(" << v->dimensions() << ") "
+				    << "and random_projection input(" << input_dimension_ << ") do not match";
+				throw euclidean_vector_error(buf.str());
+			}
+			data.push_back(&(*v)[0]);
+		}
+		for (auto* v : out) {
+			if (v->dimensions() != output_dimension_) {
+				*v = euclidean_vector(output_dimension_);
+			}
+		}
+
+		auto const achlioptas = distribution_ == distribution::achlioptas;
+		auto& row = ws.row_;
+		row.resize(ULONG(input_dimension_));
+		for (auto i = size_type{0}; i < output_dimension_; ++i) {
+			auto const key = row_key(seed_, i);
+			if (achlioptas) {
+				generate_signs(key, row);
+			}
+			else {
+				generate_gaussian(key, scale_, row);
+			}
+			// Achlioptas rows hold signs, scaled once per sum.
+			auto n = std::size_t{0};
+			for (double sums[row_inputs]; n + row_inputs <= data.size(); n += row_inputs) {
+				dense_rows<row_inputs>(row, data.data() + n, sums);
+				for (auto m = std::size_t{0}; m < row_inputs; ++m) {
+					(*out[n + m])[i] = achlioptas ? scale_ * sums[m] : sums[m];
+				}
+			}
+			for (double sum[1]; n < data.size(); ++n) {
+				dense_rows<1>(row, data.data() + n, sum);
+				(*out[n])[i] = achlioptas ? scale_ * sum[0] : sum[0];
+			}
+		}
+	}
+
+} // namespace comp6771
@@ -0,0 +1,419 @@
+// Copyright (c) Christopher Di Bella.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+#include "comp6771/vector_pipeline.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace comp6771 {
+
+	namespace {
+		using clock = std::chrono::steady_clock;
+
+		auto nanoseconds_since(clock::time_point start) -> std::uint64_t {
+			return static_cast<std::uint64_t>(
+			   std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start).count());
+		}
+
+		// Tries this many times before parking a waiting thread.
+		constexpr auto spin_limit = 64;
+	} // namespace
+
+	/*	          Internal Types		*/
+
+	// A vector travelling through the pipeline, and the spare it may swap with.
+	struct vector_pipeline::item {
+		euclidean_vector value = euclidean_vector(0);
+		euclidean_vector scratch = euclidean_vector(0);
+	};
+
+	// A micro-batch. items[0, size) are live; the rest are buffers kept for reuse.
+	struct vector_pipeline::batch {
+		std::vector<item> items;
+		std::size_t size = 0;
+		clock::time_point started;
+	};
+
+	struct vector_pipeline::counters {
+		std::atomic<std::uint64_t> items_in{0};
+		std::atomic<std::uint64_t> items_out{0};
+		std::atomic<std::uint64_t> batches{0};
+		std::atomic<std::uint64_t> busy{0};
+		std::atomic<std::uint64_t> blocked{0};
+		std::atomic<std::uint64_t> total_latency{0};
+		std::atomic<std::uint64_t> max_latency{0};
+
+		auto reset() -> void {
+			for (auto* counter :
+			     {&items_in, &items_out, &batches, &busy, &blocked, &total_latency, &max_latency}) {
+				counter->store(0, std::memory_order_relaxed);
+			}
+		}
+		// Each counter has a single writer, so relaxed read-modify-writes are enough.
+		auto record(std::uint64_t in, std::uint64_t out, std::uint64_t busy_ns, batch const& b)
+		   -> void {
+			items_in.fetch_add(in, std::memory_order_relaxed);
+			items_out.fetch_add(out, std::memory_order_relaxed);
+			batches.fetch_add(1, std::memory_order_relaxed);
+			busy.fetch_add(busy_ns, std::memory_order_relaxed);
+			auto const latency = nanoseconds_since(b.started);
+			total_latency.fetch_add(latency, std::memory_order_relaxed);
+			if (latency > max_latency.load(std::memory_order_relaxed)) {
+				max_latency.store(latency, std::memory_order_relaxed);
+			}
+		}
+	};
+
+	namespace {
+		auto swap_items(euclidean_vector& value1,
+		                euclidean_vector& scratch1,
+		                euclidean_vector& value2,
+		                euclidean_vector& scratch2) noexcept -> void {
+			swap(value1, value2);
+			swap(scratch1, scratch2);
+		}
+	} // namespace
+
+	/*	          Constructor Section		*/
+
+	vector_pipeline::vector_pipeline()
+	: vector_pipeline(options{}) {}
+	vector_pipeline::vector_pipeline(options opts)
+	: batch_size_{std::max(opts.batch_size, std::size_t{1})}
+	, queue_capacity_{std::max(opts.queue_capacity, std::size_t{1})}
+	, names_{"source", "sink"}
+	, pool_{std::make_unique<detail::spsc_queue<std::unique_ptr<batch>>>(0)}
+	, batches_allocated_{0}
+	, source_dimension_{-1} {
+		counters_.push_back(std::make_unique<counters>());
+		counters_.push_back(std::make_unique<counters>());
+	}
+	vector_pipeline::~vector_pipeline() = default;
+
+	/*			Member Functions 		*/
+
+	auto vector_pipeline::add_stage(std::string name, stage_function f) -> vector_pipeline& {
+		if (!f) {
+			throw std::invalid_argument("vector_pipeline stage " + name + " has no function");
+		}
+		// names_ and counters_ end with the sink.
+		names_.insert(names_.end() - 1, std::move(name));
+		counters_.insert(counters_.end() - 1, std::make_unique<counters>());
+		stages_.push_back(std::move(f));
+		batch_stages_.emplace_back();
+		return *this;
+	}
+	auto vector_pipeline::add_stage(std::string name, batch_stage_function f) -> vector_pipeline& {
+		if (!f) {
+			throw std::invalid_argument("vector_pipeline stage " + name + " has no function");
+		}
+		names_.insert(names_.end() - 1, std::move(name));
+		counters_.insert(counters_.end() - 1, std::make_unique<counters>());
+		stages_.emplace_back();
+		batch_stages_.push_back(std::move(f));
+		return *this;
+	}
+
+	auto vector_pipeline::run(source_function const& source, sink_function const& sink) -> void {
+		using batch_ptr = std::unique_ptr<batch>;
+		using queue = detail::spsc_queue<batch_ptr>;
+
+		// queues[s] feeds stage s; the last one feeds the sink.
+		auto const hops = stages_.size() + 1;
+		auto queues = std::vector<std::unique_ptr<queue>>();
+		for (auto h = std::size_t{0}; h < hops; ++h) {
+			queues.push_back(std::make_unique<queue>(queue_capacity_));
+		}
+		// Every batch in flight must fit in the pool, so returning one never fails.
+		auto const in_flight = hops * queues.front()->capacity() + hops + 1;
+		if (pool_->capacity() < in_flight) {
+			auto larger = std::make_unique<queue>(in_flight);
+			for (auto b = batch_ptr(); pool_->try_pop(b);) {
+				larger->try_push(b);
+			}
+			pool_ = std::move(larger);
+		}
+		for (auto& c : counters_) {
+			c->reset();
+		}
+
+		auto failed = std::atomic<bool>{false};
+		auto error = std::exception_ptr();
+		auto error_mutex = std::mutex();
+		auto const fail = [&](std::exception_ptr e) {
+			auto const lock = std::lock_guard(error_mutex);
+			if (!error) {
+				error = std::move(e);
+			}
+			failed.store(true, std::memory_order_release);
+			// Parked threads must see `failed`, or shutdown could deadlock.
+			for (auto& q : queues) {
+				q->wake();
+			}
+		};
+		// Waits for room downstream; false if the pipeline failed meanwhile.
+		auto const push = [&](queue& q, batch_ptr& b, counters& c) {
+			if (q.try_push(b)) {
+				return true;
+			}
+			auto const start = clock::now();
+			for (auto spins = 0; !q.try_push(b);) {
+				if (failed.load(std::memory_order_acquire)) {
+					return false;
+				}
+				if (++spins > spin_limit) {
+					q.wait_until_pushable(failed);
+				}
+			}
+			c.blocked.fetch_add(nanoseconds_since(start), std::memory_order_relaxed);
+			return true;
+		};
+		// Waits for a batch from upstream; false once upstream is finished or the pipeline failed.
+		auto const pop = [&](queue& q, batch_ptr& b) {
+			for (auto spins = 0; !q.try_pop(b);) {
+				if (q.closed()) {
+					return q.try_pop(b);
+				}
+				if (failed.load(std::memory_order_acquire)) {
+					return false;
+				}
+				if (++spins > spin_limit) {
+					q.wait_until_poppable(failed);
+				}
+			}
+			return true;
+		};
+
+		auto threads = std::vector<std::thread>();
+		threads.reserve(hops);
+		try {
+			for (auto s = std::size_t{0}; s < stages_.size(); ++s) {
+				threads.emplace_back([&, s] {
+					auto& stage = stages_[s];
+					auto& whole_batch = batch_stages_[s];
+					auto& c = *counters_[s + 1];
+					try {
+						for (auto b = batch_ptr(); pop(*queues[s], b);) {
+							auto const start = clock::now();
+							auto const in = b->size;
+							if (whole_batch) {
+								whole_batch(batch_view(b->items.data(), in));
+							}
+							else {
+								// Kept items are compacted in order; dropped ones end up past the
+								// live range, where their buffers wait for reuse.
+								auto kept = std::size_t{0};
+								for (auto i = std::size_t{0}; i < in; ++i) {
+									auto& it = b->items[i];
+									if (!stage(it.value, it.scratch)) {
+										continue;
+									}
+									if (i != kept) {
+										auto& to = b->items[kept];
+										swap_items(it.value, it.scratch, to.value, to.scratch);
+									}
+									++kept;
+								}
+								b->size = kept;
+							}
+							auto const kept = b->size;
+							c.record(in, kept, nanoseconds_since(start), *b);
+							if (!push(*queues[s + 1], b, c)) {
+								break;
+							}
+						}
+					} catch (...) {
+						fail(std::current_exception());
+					}
+					queues[s + 1]->close();
+				});
+			}
+			threads.emplace_back([&] {
+				auto& c = *counters_.back();
+				try {
+					for (auto b = batch_ptr(); pop(*queues.back(), b);) {
+						auto const start = clock::now();
+						for (auto i = std::size_t{0}; i < b->size; ++i) {
+							sink(b->items[i].value);
+						}
+						c.record(b->size, b->size, nanoseconds_since(start), *b);
+						pool_->try_push(b);
+					}
+				} catch (...) {
+					fail(std::current_exception());
+				}
+			});
+		} catch (...) {
+			// The threads already started are waiting on queues nobody will feed: stop and join
+			// them before the exception leaves, or destroying a joinable std::thread terminates.
+			fail(std::current_exception());
+			for (auto& q : queues) {
+				q->close();
+			}
+			for (auto& t : threads) {
+				t.join();
+			}
+			throw;
+		}
+
+		// The source runs here. It refills batches from the pool, handing each slot the buffer
+		// whose dimension matches what the source produced last.
+		auto& c = *counters_.front();
+		try {
+			for (auto exhausted = false; !exhausted && !failed.load(std::memory_order_acquire);) {
+				auto b = batch_ptr();
+				if (!pool_->try_pop(b)) {
+					b = std::make_unique<batch>();
+					batches_allocated_.fetch_add(1, std::memory_order_relaxed);
+				}
+				if (b->items.size() < batch_size_) {
+					b->items.resize(batch_size_);
+				}
+				b->size = 0;
+				b->started = clock::now();
+				while (b->size < batch_size_) {
+					auto& it = b->items[b->size];
+					if (it.value.dimensions() != source_dimension_
+					    && it.scratch.dimensions() == source_dimension_) {
+						swap(it.value, it.scratch);
+					}
+					if (!source(it.value)) {
+						exhausted = true;
+						break;
+					}
+					source_dimension_ = it.value.dimensions();
+					++b->size;
+				}
+				c.record(b->size, b->size, nanoseconds_since(b->started), *b);
+				if (!push(*queues.front(), b, c)) {
+					break;
+				}
+			}
+		} catch (...) {
+			fail(std::current_exception());
+		}
+		queues.front()->close();
+
+		for (auto& t : threads) {
+			t.join();
+		}
+		if (error) {
+			std::rethrow_exception(error);
+		}
+	}
+
+	auto vector_pipeline::stats() const -> std::vector<stage_stats> {
+		auto res = std::vector<stage_stats>();
+		res.reserve(counters_.size());
+		for (auto i = std::size_t{0}; i < counters_.size(); ++i) {
+			auto const& c = *counters_[i];
+			auto s = stage_stats();
+			s.name = names_[i];
+			s.items_in = c.items_in.load(std::memory_order_relaxed);
+			s.items_out = c.items_out.load(std::memory_order_relaxed);
+			s.batches = c.batches.load(std::memory_order_relaxed);
+			s.busy = std::chrono::nanoseconds(c.busy.load(std::memory_order_relaxed));
+			s.blocked = std::chrono::nanoseconds(c.blocked.load(std::memory_order_relaxed));
+			s.total_latency = std::chrono::nanoseconds(c.total_latency.load(std::memory_order_relaxed));
+			s.max_latency = std::chrono::nanoseconds(c.max_latency.load(std::memory_order_relaxed));
+			res.push_back(std::move(s));
+		}
+		return res;
+	}
+	auto vector_pipeline::batches_allocated() const -> std::uint64_t {
+		return batches_allocated_.load(std::memory_order_relaxed);
+	}
+
+	/*			batch_view 		*/
+
+	vector_pipeline::batch_view::batch_view(item* items, std::size_t size)
+	: items_{items}
+	, size_{size} {}
+	auto vector_pipeline::batch_view::size() const -> std::size_t {
+		return size_;
+	}
+	auto vector_pipeline::batch_view::value(std::size_t i) const -> euclidean_vector& {
+		return items_[i].value;
+	}
+	auto vector_pipeline::batch_view::scratch(std::size_t i) const -> euclidean_vector& {
+		return items_[i].scratch;
+	}
+
+	/*			Stage Functions 		*/
+
+	auto vector_pipeline::unit_stage() -> stage_function {
+		return [](euclidean_vector& v, euclidean_vector&) {
+			if (v.dimensions() == 0) {
+				return false;
+			}
+			// Same value as euclidean_norm(v), without allocating its cache.
+			auto const norm = std::sqrt(dot(v, v));
+			if (norm == 0) {
+				return false;
+			}
+			v /= norm;
+			return true;
+		};
+	}
+	auto vector_pipeline::scale_stage(double coefficient) -> stage_function {
+		return [coefficient](euclidean_vector& v, euclidean_vector&) {
+			v *= coefficient;
+			return true;
+		};
+	}
+	auto vector_pipeline::projection_stage(random_projection const& rp) -> batch_stage_function {
+		// Kept with the stage, which only ever runs on its own thread, so that projecting a batch
+		// reuses the same buffers every time.
+		struct buffers {
+			random_projection::workspace ws;
+			std::vector<euclidean_vector const*> in;
+			std::vector<euclidean_vector*> out;
+		};
+		return [&rp, b = std::make_shared<buffers>()](batch_view items) {
+			b->in.clear();
+			b->out.clear();
+			for (auto i = std::size_t{0}; i < items.size(); ++i) {
+				b->in.push_back(&items.value(i));
+				b->out.push_back(&items.scratch(i));
+			}
+			rp.project_into(b->in, b->out, b->ws);
+			for (auto i = std::size_t{0}; i < items.size(); ++i) {
+				swap(items.value(i), items.scratch(i));
+			}
+		};
+	}
+	auto vector_pipeline::norm_filter_stage(double min_norm, double max_norm) -> stage_function {
+		return [min_norm, max_norm](euclidean_vector& v, euclidean_vector&) {
+			auto const norm = std::sqrt(dot(v, v));
+			return norm >= min_norm && norm <= max_norm;
+		};
+	}
+
+	/*			stage_stats 		*/
+
+	auto stage_stats::throughput() const -> double {
+		if (busy.count() == 0) {
+			return 0;
+		}
+		return static_cast<double>(items_in) / std::chrono::duration<double>(busy).count();
+	}
+	auto stage_stats::mean_latency() const -> std::chrono::nanoseconds {
+		if (batches == 0) {
+			return std::chrono::nanoseconds{0};
+		}
+		return total_latency / static_cast<std::chrono::nanoseconds::rep>(batches);
+	}
+
+} // namespace comp6771
@@ -255,4 +255,39 @@ TEST_CASE("Utility function tests") {
 	auto const x1 = comp6771::euclidean_vector{1, 2, 3};
 	auto const y1 = comp6771::euclidean_vector{4, 5, 6};
 	CHECK(dot(x1, y1) == 32);
-}
\ No newline at end of file
+}
+TEST_CASE("Reproducible reduction tests") {
+	// Small inputs agree exactly with the sequential result.
+	auto const x1 = comp6771::euclidean_vector{1, 2, 3};
+	auto const y1 = comp6771::euclidean_vector{4, 5, 6};
+	CHECK(dot(x1, y1, comp6771::reduction::reproducible) == 32);
+	CHECK(euclidean_norm(x1, comp6771::reduction::reproducible) == std::sqrt(14.0));
+	CHECK(dot(x1, y1, comp6771::reduction::sequential) == dot(x1, y1));
+	CHECK(euclidean_norm(comp6771::euclidean_vector(0), comp6771::reduction::reproducible) == 0);
+	CHECK_THROWS_MATCHES(dot(x1, comp6771::euclidean_vector{1}, comp6771::reduction::reproducible),
+	                     comp6771::euclidean_vector_error,
+	                     Catch::Matchers::Message("Dimensions of LHS(3) and RHS(1) do not match"));
+
+	// Long vectors give the same bits whatever the number of threads. The length is deliberately
+	// not a multiple of the block or lane size.
+	auto const dim = 1'000'003;
+	auto x = comp6771::euclidean_vector(dim);
+	auto y = comp6771::euclidean_vector(dim);
+	for (auto i = 0; i < dim; ++i) {
+		x[i] = std::sin(i) * 1e3;
+		y[i] = std::cos(i * 0.5) / 7;
+	}
+	auto const expected_dot = dot(x, y, comp6771::reduction::reproducible, 1);
+	auto const expected_norm = euclidean_norm(x, comp6771::reduction::reproducible, 1);
+	for (auto const threads : {2, 3, 7, 64, 0}) {
+		CHECK(dot(x, y, comp6771::reduction::reproducible, threads) == expected_dot);
+		CHECK(euclidean_norm(x, comp6771::reduction::reproducible, threads) == expected_norm);
+	}
+
+	// Blocked pairwise summation loses far less precision than one running accumulator.
+	auto const tenths = comp6771::euclidean_vector(dim, 0.1);
+	auto const ones = comp6771::euclidean_vector(dim, 1.0);
+	auto const exact = dim * 0.1;
+	CHECK(std::abs(dot(tenths, ones, comp6771::reduction::reproducible) - exact)
+	      < std::abs(dot(tenths, ones) - exact));
+}
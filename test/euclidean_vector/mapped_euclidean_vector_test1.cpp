@@ -0,0 +1,234 @@
+#include "comp6771/mapped_euclidean_vector.hpp"
+#include <catch2/catch.hpp>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <linux/magic.h>
+#include <string>
+#include <sys/vfs.h>
+#include <unistd.h>
+#include <utility>
+
+/*
+   Tests for mapped_euclidean_vector, the out-of-core euclidean vector backed by a memory-mapped
+   file. Every test works in its own scratch directory under the system temporary directory.
+   1)  File tests: creating, reopening (read-write and read-only) and indexing a mapped vector,
+       and the errors thrown.
+   2)  Operation tests: each element-wise operator against the same operation on an in-memory
+       euclidean_vector, over a length that spans several streaming chunks.
+   3)  Utility function tests: dot and euclidean_norm must match euclidean_vector bit for bit,
+       whatever number of threads they are allowed.
+   4)  Out-of-core test: hidden by default ([.large]); maps a sparse vector of more than 2^31
+       components and at least twice the physical memory, then streams dot and euclidean_norm
+       through it. Run it with `mapped_euclidean_vector_test1 [large]`. Its file goes under
+       $COMP6771_SCRATCH_DIR if set, else the system temporary directory, and the test fails
+       straight away if that is a tmpfs, where the file would have to fit in memory.
+*/
+
+namespace {
+	// A scratch directory that is removed with everything in it at the end of the test.
+	class scratch_directory {
+	public:
+		explicit scratch_directory(std::string const& name)
+		: scratch_directory(std::filesystem::temp_directory_path(), name) {}
+		scratch_directory(std::filesystem::path const& base, std::string const& name)
+		: path_{base / (name + "." + std::to_string(::getpid()))} {
+			std::filesystem::create_directories(path_);
+		}
+		scratch_directory(scratch_directory const&) = delete;
+		auto operator=(scratch_directory const&) -> scratch_directory& = delete;
+		~scratch_directory() {
+			auto ec = std::error_code{};
+			std::filesystem::remove_all(path_, ec);
+		}
+		[[nodiscard]] auto file(std::string const& name) const -> std::string {
+			return (path_ / name).string();
+		}
+
+	private:
+		std::filesystem::path path_;
+	};
+
+	// $COMP6771_SCRATCH_DIR, or the system temporary directory when it is unset.
+	auto large_scratch_base() -> std::filesystem::path {
+		auto const* const dir = std::getenv("COMP6771_SCRATCH_DIR");
+		return dir != nullptr && *dir != '\0' ? std::filesystem::path(dir)
+		                                      : std::filesystem::temp_directory_path();
+	}
+
+	auto is_tmpfs(std::filesystem::path const& dir) -> bool {
+		struct statfs info {};
+		return ::statfs(dir.c_str(), &info) == 0 && info.f_type == TMPFS_MAGIC;
+	}
+
+	// Spans three streaming chunks plus a ragged tail.
+	constexpr auto long_dim = comp6771::mapped_euclidean_vector::size_type{(3 << 20) + 17};
+
+	auto fill(comp6771::mapped_euclidean_vector& mv, comp6771::euclidean_vector& ev, double phase)
+	   -> void {
+		for (auto i = comp6771::euclidean_vector::size_type{0}; i < ev.dimensions(); ++i) {
+			auto const value = std::sin(static_cast<double>(i) * 0.001 + phase) * 100;
+			mv[i] = value;
+			ev[i] = value;
+		}
+	}
+
+	auto same(comp6771::mapped_euclidean_vector const& mv, comp6771::euclidean_vector const& ev)
+	   -> bool {
+		return static_cast<comp6771::euclidean_vector>(mv) == ev;
+	}
+} // namespace
+
+TEST_CASE("File tests") {
+	auto const dir = scratch_directory("mapped_file_tests");
+
+	// create: every magnitude starts at the given value.
+	{
+		auto mv = comp6771::mapped_euclidean_vector::create(dir.file("a.bin"), 5, 2.5);
+		CHECK(mv.dimensions() == 5);
+		CHECK(mv.path() == dir.file("a.bin"));
+		CHECK(mv.at(4) == 2.5);
+		mv[1] = 7;
+		mv.at(3) = -1;
+		mv.flush();
+	}
+	CHECK(std::filesystem::file_size(dir.file("a.bin")) == 5 * sizeof(double));
+
+	// open: the file keeps what was written through the previous mapping.
+	auto const reopened = comp6771::mapped_euclidean_vector::open(dir.file("a.bin"));
+	CHECK(static_cast<comp6771::euclidean_vector>(reopened)
+	      == comp6771::euclidean_vector{2.5, 7, 2.5, -1, 2.5});
+	CHECK_THROWS_MATCHES(reopened.at(5),
+	                     comp6771::euclidean_vector_error,
+	                     Catch::Matchers::Message("Index 5 is not valid for this "
+	                                              "mapped_euclidean_vector object"));
+
+	// read_only: reading works, and every way of writing throws instead of faulting.
+	std::filesystem::permissions(dir.file("a.bin"), std::filesystem::perms::owner_read);
+	auto read_only = comp6771::mapped_euclidean_vector::open(
+	   dir.file("a.bin"),
+	   comp6771::mapped_euclidean_vector::access::read_only);
+	CHECK_FALSE(read_only.writable());
+	CHECK(reopened.writable());
+	CHECK(std::as_const(read_only)[1] == 7);
+	CHECK(std::as_const(read_only).at(3) == -1);
+	CHECK(read_only == reopened);
+	CHECK(same(read_only * 2, comp6771::euclidean_vector{5, 14, 5, -2, 5}));
+	auto const message = Catch::Matchers::Message(dir.file("a.bin") + " is mapped read-only");
+	CHECK_THROWS_MATCHES(read_only[0] = 1, comp6771::euclidean_vector_error, message);
+	CHECK_THROWS_MATCHES(read_only.at(0) = 1, comp6771::euclidean_vector_error, message);
+	CHECK_THROWS_MATCHES(read_only *= 2, comp6771::euclidean_vector_error, message);
+	CHECK_THROWS_MATCHES(read_only /= 2, comp6771::euclidean_vector_error, message);
+	CHECK_THROWS_MATCHES(read_only += reopened, comp6771::euclidean_vector_error, message);
+	CHECK_THROWS_MATCHES(read_only -= reopened, comp6771::euclidean_vector_error, message);
+	CHECK(same(read_only, comp6771::euclidean_vector{2.5, 7, 2.5, -1, 2.5}));
+
+	// move: the moved-from vector is left empty.
+	auto moved = comp6771::mapped_euclidean_vector::create(dir.file("b.bin"), 3);
+	auto const moved_to = std::move(moved);
+	CHECK(moved_to.dimensions() == 3);
+	CHECK(moved_to.at(2) == 0);
+
+	// zero dimensions are allowed.
+	auto const empty = comp6771::mapped_euclidean_vector::create(dir.file("c.bin"), 0);
+	CHECK(empty.dimensions() == 0);
+	CHECK(euclidean_norm(empty) == 0);
+	CHECK(static_cast<comp6771::euclidean_vector>(empty).dimensions() == 0);
+
+	CHECK_THROWS_AS(comp6771::mapped_euclidean_vector::open(dir.file("missing.bin")),
+	                comp6771::euclidean_vector_error);
+}
+
+TEST_CASE("Mapped operation tests") {
+	auto const dir = scratch_directory("mapped_operation_tests");
+	auto mx = comp6771::mapped_euclidean_vector::create(dir.file("x.bin"), long_dim);
+	auto my = comp6771::mapped_euclidean_vector::create(dir.file("y.bin"), long_dim);
+	auto ex = comp6771::euclidean_vector(long_dim);
+	auto ey = comp6771::euclidean_vector(long_dim);
+	fill(mx, ex, 0.0);
+	fill(my, ey, 1.0);
+
+	CHECK(same(+mx, ex));
+	CHECK(same(-mx, -ex));
+	CHECK(same(mx + my, ex + ey));
+	CHECK(same(mx - my, ex - ey));
+	CHECK(same(mx * 3, ex * 3));
+	CHECK(same(3 * mx, 3 * ex));
+	CHECK(same(mx / 4, ex / 4));
+	CHECK(mx == mx);
+	CHECK(mx != my);
+	// Operators leave their operands and the files behind them untouched.
+	CHECK(same(mx, ex));
+	CHECK(mx.path() == dir.file("x.bin"));
+	CHECK((mx + my).path().empty());
+
+	mx += my;
+	ex += ey;
+	CHECK(same(mx, ex));
+	mx -= my;
+	ex -= ey;
+	CHECK(same(mx, ex));
+	mx *= 1.5;
+	ex *= 1.5;
+	CHECK(same(mx, ex));
+	mx /= 7;
+	ex /= 7;
+	CHECK(same(mx, ex));
+
+	auto short_vector = comp6771::mapped_euclidean_vector::create(dir.file("s.bin"), 2);
+	CHECK_THROWS_MATCHES(mx += short_vector,
+	                     comp6771::euclidean_vector_error,
+	                     Catch::Matchers::Message("Dimensions of LHS(3145745) and RHS(2) do not "
+	                                              "match"));
+	CHECK_THROWS_MATCHES(mx / 0,
+	                     comp6771::euclidean_vector_error,
+	                     Catch::Matchers::Message("Invalid vector division by 0"));
+}
+
+TEST_CASE("Mapped utility function tests") {
+	auto const dir = scratch_directory("mapped_utility_tests");
+	auto mx = comp6771::mapped_euclidean_vector::create(dir.file("x.bin"), long_dim);
+	auto my = comp6771::mapped_euclidean_vector::create(dir.file("y.bin"), long_dim);
+	auto ex = comp6771::euclidean_vector(long_dim);
+	auto ey = comp6771::euclidean_vector(long_dim);
+	fill(mx, ex, 0.5);
+	fill(my, ey, 2.0);
+
+	// Streaming through the file reduces to exactly the in-memory result.
+	CHECK(dot(mx, my) == dot(ex, ey, comp6771::reduction::reproducible));
+	CHECK(euclidean_norm(mx) == euclidean_norm(ex, comp6771::reduction::reproducible));
+	CHECK(dot(mx, my, comp6771::reduction::sequential) == dot(ex, ey));
+	CHECK(euclidean_norm(mx, comp6771::reduction::sequential) == euclidean_norm(ex));
+
+	// Bounding the workers never changes the bits.
+	for (auto const threads : {1, 2, 3, 0}) {
+		CHECK(dot(mx, my, comp6771::reduction::reproducible, threads) == dot(mx, my));
+		CHECK(euclidean_norm(mx, comp6771::reduction::reproducible, threads) == euclidean_norm(mx));
+	}
+	CHECK(dot(mx, my, comp6771::reduction::sequential, 2) == dot(ex, ey));
+}
+
+TEST_CASE("Out-of-core test", "[.large]") {
+	auto const base = large_scratch_base();
+	if (is_tmpfs(base)) {
+		FAIL(base.string() << " is a tmpfs, so the file would live in memory; set "
+		                      "COMP6771_SCRATCH_DIR to a directory on disk");
+	}
+	auto const dir = scratch_directory(base, "mapped_large_test");
+	auto const memory = static_cast<comp6771::mapped_euclidean_vector::size_type>(
+	   ::sysconf(_SC_PHYS_PAGES) * ::sysconf(_SC_PAGESIZE));
+	auto const past_int = comp6771::mapped_euclidean_vector::size_type{1} << 31U;
+	auto const dim = std::max(2 * memory / 8, past_int + 3);
+
+	// The file is sparse: only the pages written below take up disk space.
+	auto v = comp6771::mapped_euclidean_vector::create(dir.file("large.bin"), dim);
+	CHECK(v.dimensions() == dim);
+	v[0] = 3;
+	v[past_int + 1] = 4;
+	v.at(dim - 1) = 12;
+	CHECK(v.at(past_int + 1) == 4);
+
+	CHECK(dot(v, v) == 169);
+	CHECK(euclidean_norm(v) == 13);
+	CHECK(euclidean_norm(v, comp6771::reduction::sequential) == 13);
+}
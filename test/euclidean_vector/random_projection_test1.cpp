@@ -0,0 +1,152 @@
+#include "comp6771/random_projection.hpp"
+#include <catch2/catch.hpp>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+/*
+   Tests for random_projection, the Johnson-Lindenstrauss transformer.
+   1)  Matrix tests: entries are a pure function of (seed, row, column) and follow the requested
+       distribution.
+   2)  Projection tests: single vectors, batches and project_into agree with each other and with
+       the matrix entries, and the errors thrown.
+   3)  Distortion tests: every pairwise distance among a set of points survives projection to
+       jl_dimension() within the requested epsilon.
+*/
+
+namespace {
+	using size_type = comp6771::euclidean_vector::size_type;
+
+	// Deterministic, roughly uniform points in [-1, 1]^dim.
+	auto make_points(size_type count, size_type dim) -> std::vector<comp6771::euclidean_vector> {
+		auto points = std::vector<comp6771::euclidean_vector>();
+		auto state = std::uint64_t{12345};
+		for (auto p = size_type{0}; p < count; ++p) {
+			auto v = comp6771::euclidean_vector(dim);
+			for (auto i = size_type{0}; i < dim; ++i) {
+				state = state * 6364136223846793005U + 1442695040888963407U;
+				v[i] = static_cast<double>(state >> 11U) / 4503599627370496.0 * 2 - 1;
+			}
+			points.push_back(v);
+		}
+		return points;
+	}
+} // namespace
+
+TEST_CASE("Matrix tests") {
+	auto const dist = GENERATE(comp6771::random_projection::distribution::achlioptas,
+	                           comp6771::random_projection::distribution::gaussian);
+	auto const k = size_type{64};
+	auto const d = size_type{3001};
+	auto const rp = comp6771::random_projection(d, k, 42, dist);
+	auto const same_seed = comp6771::random_projection(d, k, 42, dist);
+	auto const other_seed = comp6771::random_projection(d, k, 43, dist);
+	CHECK(rp.input_dimensions() == d);
+	CHECK(rp.output_dimensions() == k);
+
+	auto sum = 0.0;
+	auto sum_squares = 0.0;
+	auto zeros = 0;
+	auto differences = 0;
+	for (auto i = size_type{0}; i < k; ++i) {
+		for (auto j = size_type{0}; j < d; ++j) {
+			auto const e = rp.entry(i, j);
+			CHECK(e == same_seed.entry(i, j));
+			differences += e != other_seed.entry(i, j) ? 1 : 0;
+			sum += e;
+			sum_squares += e * e;
+			zeros += e == 0 ? 1 : 0;
+		}
+	}
+	auto const count = static_cast<double>(k * d);
+	// Every entry has mean 0 and variance 1/k.
+	CHECK(std::abs(sum / count) < 0.01);
+	CHECK(sum_squares / count * static_cast<double>(k) == Approx(1.0).epsilon(0.02));
+	CHECK(differences > 0);
+	if (dist == comp6771::random_projection::distribution::achlioptas) {
+		CHECK(zeros / count == Approx(2.0 / 3).epsilon(0.01));
+		CHECK(std::abs(rp.entry(0, 0)) <= std::sqrt(3.0 / 64));
+	}
+	else {
+		CHECK(zeros == 0);
+	}
+
+	CHECK_THROWS_MATCHES(rp.entry(k, 0),
+	                     comp6771::euclidean_vector_error,
+	                     Catch::Matchers::Message("Entry (64, 0) is not valid for this "
+	                                              "random_projection object"));
+	CHECK_THROWS_AS(comp6771::random_projection(0, 4, 1), comp6771::euclidean_vector_error);
+}
+
+TEST_CASE("Projection tests") {
+	auto const dist = GENERATE(comp6771::random_projection::distribution::achlioptas,
+	                           comp6771::random_projection::distribution::gaussian);
+	auto const rp = comp6771::random_projection(5, 3, 7, dist);
+	auto const v = comp6771::euclidean_vector{1, -2, 3, 0.5, 4};
+
+	// Single vectors match the matrix product.
+	auto const projected = rp(v);
+	REQUIRE(projected.dimensions() == 3);
+	for (auto i = size_type{0}; i < 3; ++i) {
+		auto expected = 0.0;
+		for (auto j = size_type{0}; j < 5; ++j) {
+			expected += rp.entry(i, j) * v[j];
+		}
+		CHECK(projected[i] == Approx(expected).margin(1e-12));
+	}
+
+	// Batches and project_into give the same vectors.
+	auto const batch = std::vector<comp6771::euclidean_vector>{v, 2 * v, -v};
+	auto const projected_batch = rp(batch);
+	REQUIRE(projected_batch.size() == 3);
+	CHECK(projected_batch[0] == projected);
+	CHECK(projected_batch[2] == -projected);
+	auto out = comp6771::euclidean_vector(3);
+	rp.project_into(2 * v, out);
+	CHECK(out == projected_batch[1]);
+	auto in_place = v;
+	rp.project_into(in_place, in_place);
+	CHECK(in_place == projected);
+
+	// Batches are applied several vectors at a time; sizes that do not divide evenly, and odd
+	// dimensions, still give exactly the single-vector results.
+	auto const wide = comp6771::random_projection(4099, 17, 11, dist);
+	auto const wide_batch = make_points(7, 4099);
+	auto const wide_projected = wide(wide_batch);
+	for (auto i = std::size_t{0}; i < wide_batch.size(); ++i) {
+		CHECK(wide_projected[i] == wide(wide_batch[i]));
+	}
+	auto expected = 0.0;
+	for (auto j = size_type{0}; j < 4099; ++j) {
+		expected += wide.entry(16, j) * wide_batch[6][j];
+	}
+	CHECK(wide_projected[6][16] == Approx(expected).margin(1e-9));
+
+	CHECK_THROWS_MATCHES(rp(comp6771::euclidean_vector{1, 2}),
+	                     comp6771::euclidean_vector_error,
+	                     Catch::Matchers::Message("Dimensions of euclidean_vector(2) and "
+	                                              "random_projection input(5) do not match"));
+}
+
+TEST_CASE("Distortion tests") {
+	auto const dist = GENERATE(comp6771::random_projection::distribution::achlioptas,
+	                           comp6771::random_projection::distribution::gaussian);
+	auto const points = size_type{12};
+	auto const d = size_type{10000};
+	auto const epsilon = 0.5;
+	auto const k = comp6771::random_projection::jl_dimension(points, epsilon);
+	CHECK(k == 120);
+
+	auto const data = make_points(points, d);
+	auto const rp = comp6771::random_projection(d, k, 2021, dist);
+	auto const projected = rp(data);
+	for (auto a = std::size_t{0}; a < data.size(); ++a) {
+		for (auto b = a + 1; b < data.size(); ++b) {
+			auto const exact = euclidean_norm(data[a] - data[b]);
+			auto const approx = euclidean_norm(projected[a] - projected[b]);
+			CHECK(std::abs(approx / exact - 1) < epsilon);
+		}
+	}
+	CHECK_THROWS_AS(comp6771::random_projection::jl_dimension(10, 1.5),
+	                comp6771::euclidean_vector_error);
+}
@@ -0,0 +1,392 @@
+#include "comp6771/detail/spsc_queue.hpp"
+#include "comp6771/vector_pipeline.hpp"
+#include <atomic>
+#include <catch2/catch.hpp>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <new>
+#include <pthread.h>
+#include <stdexcept>
+#include <sys/resource.h>
+#include <system_error>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+/*
+   Tests for vector_pipeline and the lock-free queue between its stages.
+   1)  Queue tests: ordering, capacity and transfers between two threads, spinning and parked.
+   2)  Pipeline tests: the ready-made stages give the same vectors, in the same order, as applying
+       them one vector at a time, and the counters add up.
+   3)  Buffer reuse tests: a long stream allocates a bounded number of batches, and the source is
+       handed back buffers of the dimension it produced, even through a projection. Once the pool
+       is warm, streaming through the ready-made stages makes no allocations at all.
+   4)  Backpressure and error tests: a slow sink holds the source back, and an exception thrown by
+       a stage, or by starting a stage's thread, stops the pipeline and is rethrown by run.
+   5)  Idle tests: stages waiting on a slow source sleep instead of burning CPU.
+*/
+
+namespace {
+	// Counts calls to the global operator new while `counting` is set.
+	std::atomic<bool> counting{false};
+	std::atomic<long> allocations{0};
+} // namespace
+
+auto operator new(std::size_t size) -> void* {
+	if (counting.load(std::memory_order_relaxed)) {
+		allocations.fetch_add(1, std::memory_order_relaxed);
+	}
+	if (auto* p = std::malloc(size == 0 ? 1 : size)) {
+		return p;
+	}
+	throw std::bad_alloc();
+}
+auto operator delete(void* p) noexcept -> void {
+	std::free(p);
+}
+auto operator delete(void* p, std::size_t) noexcept -> void {
+	std::free(p);
+}
+
+namespace {
+	using size_type = comp6771::euclidean_vector::size_type;
+
+	auto make_input(int i, size_type dim) -> comp6771::euclidean_vector {
+		auto v = comp6771::euclidean_vector(dim);
+		for (auto j = size_type{0}; j < dim; ++j) {
+			v[j] = std::sin(i * 0.37 + static_cast<double>(j)) * (i % 7);
+		}
+		return v;
+	}
+
+	// Makes new threads ask for a larger stack than any thread so far, which glibc cannot serve
+	// from its cache of old stacks, and caps the address space at what is mapped now plus one
+	// and a half such stacks. The first thread started afterwards fits; the second cannot map its
+	// stack. Everything is restored when destroyed.
+	class thread_stack_cap {
+	public:
+		thread_stack_cap() {
+			::getrlimit(RLIMIT_AS, &old_limit_);
+			::pthread_getattr_default_np(&old_attr_);
+			auto old_stack = std::size_t{0};
+			::pthread_attr_getstacksize(&old_attr_, &old_stack);
+			auto attr = pthread_attr_t{};
+			::pthread_attr_init(&attr);
+			auto const stack = 8 * old_stack;
+			::pthread_attr_setstacksize(&attr, stack);
+			::pthread_setattr_default_np(&attr);
+			::pthread_attr_destroy(&attr);
+
+			auto pages = rlim_t{0};
+			std::ifstream("/proc/self/statm") >> pages;
+			auto cap = old_limit_;
+			cap.rlim_cur = pages * static_cast<rlim_t>(::sysconf(_SC_PAGESIZE)) + stack + stack / 2;
+			::setrlimit(RLIMIT_AS, &cap);
+		}
+		thread_stack_cap(thread_stack_cap const&) = delete;
+		auto operator=(thread_stack_cap const&) -> thread_stack_cap& = delete;
+		~thread_stack_cap() {
+			::setrlimit(RLIMIT_AS, &old_limit_);
+			::pthread_setattr_default_np(&old_attr_);
+			::pthread_attr_destroy(&old_attr_);
+		}
+
+	private:
+		rlimit old_limit_{};
+		pthread_attr_t old_attr_{};
+	};
+
+	// A source producing `count` vectors of dimension `dim`, counting the buffers it had to replace.
+	struct counting_source {
+		int count;
+		size_type dim;
+		int produced = 0;
+		int reallocations = 0;
+
+		auto operator()(comp6771::euclidean_vector& v) -> bool {
+			if (produced == count) {
+				return false;
+			}
+			if (v.dimensions() != dim) {
+				v = comp6771::euclidean_vector(dim);
+				++reallocations;
+			}
+			for (auto j = size_type{0}; j < dim; ++j) {
+				v[j] = std::sin(produced * 0.37 + static_cast<double>(j)) * (produced % 7);
+			}
+			++produced;
+			return true;
+		}
+	};
+} // namespace
+
+TEST_CASE("Queue tests") {
+	auto q = comp6771::detail::spsc_queue<int>(3);
+	CHECK(q.capacity() == 4);
+	for (auto i = 0; i < 4; ++i) {
+		CHECK(q.try_push(i));
+	}
+	auto extra = 4;
+	CHECK_FALSE(q.try_push(extra));
+	auto out = -1;
+	for (auto i = 0; i < 4; ++i) {
+		CHECK(q.try_pop(out));
+		CHECK(out == i);
+	}
+	CHECK_FALSE(q.try_pop(out));
+
+	// Every element arrives once and in order across threads.
+	auto transfer = comp6771::detail::spsc_queue<int>(16);
+	constexpr auto total = 100'000;
+	auto producer = std::thread([&transfer] {
+		for (auto i = 0; i < total;) {
+			auto value = i;
+			if (transfer.try_push(value)) {
+				++i;
+			}
+			else {
+				std::this_thread::yield();
+			}
+		}
+		transfer.close();
+	});
+	auto expected = 0;
+	auto in_order = true;
+	for (;;) {
+		auto value = 0;
+		if (transfer.try_pop(value)) {
+			in_order = in_order && value == expected;
+			++expected;
+		}
+		else if (transfer.closed()) {
+			if (!transfer.try_pop(value)) {
+				break;
+			}
+			in_order = in_order && value == expected;
+			++expected;
+		}
+		else {
+			std::this_thread::yield();
+		}
+	}
+	producer.join();
+	CHECK(in_order);
+	CHECK(expected == total);
+
+	// Both sides park as soon as they cannot make progress; a lost wake-up would hang here.
+	auto parked = comp6771::detail::spsc_queue<int>(2);
+	auto const never = std::atomic<bool>{false};
+	auto parked_producer = std::thread([&parked, &never] {
+		for (auto i = 0; i < total; ++i) {
+			auto value = i;
+			while (!parked.try_push(value)) {
+				parked.wait_until_pushable(never);
+			}
+		}
+		parked.close();
+	});
+	auto received = 0;
+	auto parked_in_order = true;
+	for (auto value = 0;;) {
+		if (parked.try_pop(value)) {
+			parked_in_order = parked_in_order && value == received;
+			++received;
+		}
+		else if (parked.closed()) {
+			if (!parked.try_pop(value)) {
+				break;
+			}
+			parked_in_order = parked_in_order && value == received;
+			++received;
+		}
+		else {
+			parked.wait_until_poppable(never);
+		}
+	}
+	parked_producer.join();
+	CHECK(parked_in_order);
+	CHECK(received == total);
+}
+
+TEST_CASE("Pipeline tests") {
+	constexpr auto count = 1000;
+	auto pipeline = comp6771::vector_pipeline({.batch_size = 16, .queue_capacity = 4});
+	pipeline.add_stage("unit", comp6771::vector_pipeline::unit_stage())
+	   .add_stage("scale", comp6771::vector_pipeline::scale_stage(3))
+	   .add_stage("filter", comp6771::vector_pipeline::norm_filter_stage(2.5, 3.5));
+
+	auto expected = std::vector<comp6771::euclidean_vector>();
+	for (auto i = 0; i < count; ++i) {
+		auto const v = make_input(i, 8);
+		if (euclidean_norm(v) != 0) {
+			expected.push_back(unit(v) * 3);
+		}
+	}
+	auto results = std::vector<comp6771::euclidean_vector>();
+	auto source = counting_source{count, 8};
+	pipeline.run(std::ref(source), [&results](comp6771::euclidean_vector const& v) {
+		results.push_back(v);
+	});
+
+	// Zero vectors have no unit vector and are dropped; everything else arrives in order.
+	REQUIRE(results.size() == expected.size());
+	for (auto i = std::size_t{0}; i < results.size(); ++i) {
+		CHECK(results[i] == expected[i]);
+	}
+
+	auto const stats = pipeline.stats();
+	REQUIRE(stats.size() == 5);
+	CHECK(stats[0].name == "source");
+	CHECK(stats[1].name == "unit");
+	CHECK(stats[3].name == "filter");
+	CHECK(stats[4].name == "sink");
+	CHECK(stats[0].items_out == count);
+	CHECK(stats[1].items_in == count);
+	CHECK(stats[1].items_out == expected.size());
+	CHECK(stats[3].items_out == expected.size());
+	CHECK(stats[4].items_in == expected.size());
+	for (auto const& s : stats) {
+		CHECK(s.batches >= count / 16);
+		CHECK(s.max_latency >= s.mean_latency());
+	}
+	// Latency is measured from the start of the batch, so it only grows along the pipeline.
+	CHECK(stats[4].max_latency >= stats[0].max_latency);
+	CHECK(stats[1].throughput() > 0);
+
+	CHECK_THROWS_AS(pipeline.add_stage("empty", comp6771::vector_pipeline::stage_function()),
+	                std::invalid_argument);
+	CHECK_THROWS_AS(pipeline.add_stage("empty", comp6771::vector_pipeline::batch_stage_function()),
+	                std::invalid_argument);
+}
+
+TEST_CASE("Buffer reuse tests") {
+	constexpr auto count = 20'000;
+	auto const rp = comp6771::random_projection(64, 8, 99);
+	auto pipeline = comp6771::vector_pipeline({.batch_size = 32, .queue_capacity = 2});
+	pipeline.add_stage("projection", comp6771::vector_pipeline::projection_stage(rp))
+	   .add_stage("scale", comp6771::vector_pipeline::scale_stage(0.5));
+
+	auto source = counting_source{count, 64};
+	auto received = 0;
+	auto matches = true;
+	pipeline.run(std::ref(source), [&](comp6771::euclidean_vector const& v) {
+		matches = matches && v == rp(make_input(received, 64)) * 0.5;
+		++received;
+	});
+	CHECK(received == count);
+	CHECK(matches);
+
+	// Three queues of two batches, plus one batch per thread, bound what is ever allocated.
+	CHECK(pipeline.batches_allocated() <= 3 * 2 + 4);
+	// Projection swaps each 64-dimension vector for an 8-dimension one, yet the 64-dimension
+	// buffers come back to the source: only the first use of each slot allocates.
+	CHECK(source.reallocations <= static_cast<int>(pipeline.batches_allocated()) * 32);
+
+	// A second run reuses the pool from the first. It may have more batches in flight than the
+	// first managed to, but only the slots of those new batches need buffers.
+	auto const allocated = pipeline.batches_allocated();
+	auto again = counting_source{count, 64};
+	pipeline.run(std::ref(again), [](comp6771::euclidean_vector const&) {});
+	CHECK(pipeline.batches_allocated() <= 3 * 2 + 4);
+	CHECK(again.reallocations
+	      <= static_cast<int>(pipeline.batches_allocated() - allocated) * 32);
+
+	// A slow sink fills every queue while warming up, so the pool ends up holding as many batches
+	// as can ever be in flight. After that, only starting the run allocates (queues and threads).
+	auto const narrow = comp6771::random_projection(16, 8, 7);
+	auto quiet = comp6771::vector_pipeline({.batch_size = 4, .queue_capacity = 1});
+	quiet.add_stage("projection", comp6771::vector_pipeline::projection_stage(narrow))
+	   .add_stage("unit", comp6771::vector_pipeline::unit_stage())
+	   .add_stage("scale", comp6771::vector_pipeline::scale_stage(3))
+	   .add_stage("filter", comp6771::vector_pipeline::norm_filter_stage(2.5, 3.5));
+	auto warm_up = counting_source{200, 16};
+	quiet.run(std::ref(warm_up), [](comp6771::euclidean_vector const&) {
+		std::this_thread::sleep_for(std::chrono::microseconds(50));
+	});
+	auto const warm = quiet.batches_allocated();
+	auto steady = counting_source{count, 16};
+	auto const counted = [&steady](comp6771::euclidean_vector& v) {
+		if (steady.produced == 100) {
+			counting.store(true, std::memory_order_relaxed);
+		}
+		return steady(v);
+	};
+	allocations.store(0);
+	auto kept = 0;
+	quiet.run(counted, [&kept](comp6771::euclidean_vector const&) { ++kept; });
+	counting.store(false, std::memory_order_relaxed);
+	CHECK(kept > 0);
+	CHECK(quiet.batches_allocated() == warm);
+	CHECK(allocations.load() == 0);
+}
+
+TEST_CASE("Backpressure and error tests") {
+	// A slow sink fills every queue and the source has to wait.
+	auto slow = comp6771::vector_pipeline({.batch_size = 4, .queue_capacity = 1});
+	slow.add_stage("scale", comp6771::vector_pipeline::scale_stage(2));
+	auto source = counting_source{200, 4};
+	slow.run(std::ref(source), [](comp6771::euclidean_vector const&) {
+		std::this_thread::sleep_for(std::chrono::microseconds(200));
+	});
+	auto const stats = slow.stats();
+	CHECK(stats.front().items_out == 200);
+	CHECK(stats.front().blocked > std::chrono::nanoseconds{0});
+	CHECK(slow.batches_allocated() <= 2 * 1 + 3);
+
+	// A throwing stage stops the whole pipeline without deadlocking.
+	auto failing = comp6771::vector_pipeline({.batch_size = 8, .queue_capacity = 1});
+	auto seen = 0;
+	failing.add_stage("fail", [&seen](comp6771::euclidean_vector&, comp6771::euclidean_vector&) {
+		if (++seen == 500) {
+			throw comp6771::euclidean_vector_error("stage failed");
+		}
+		return true;
+	});
+	auto endless = counting_source{1'000'000, 2};
+	CHECK_THROWS_MATCHES(failing.run(std::ref(endless), [](comp6771::euclidean_vector const&) {}),
+	                     comp6771::euclidean_vector_error,
+	                     Catch::Matchers::Message("stage failed"));
+	CHECK(endless.produced < 1'000'000);
+
+	// A thread that cannot be started stops the pipeline: the threads already running are
+	// joined and run rethrows, rather than std::terminate being called.
+	auto starved = comp6771::vector_pipeline();
+	starved.add_stage("unit", comp6771::vector_pipeline::unit_stage())
+	   .add_stage("scale", comp6771::vector_pipeline::scale_stage(2))
+	   .add_stage("filter", comp6771::vector_pipeline::norm_filter_stage(0, 3));
+	auto unused = counting_source{10, 2};
+	{
+		auto const cap = thread_stack_cap();
+		CHECK_THROWS_AS(starved.run(std::ref(unused), [](comp6771::euclidean_vector const&) {}),
+		                std::system_error);
+	}
+	CHECK(unused.produced == 0);
+	// Nothing is left behind: the same pipeline runs normally once threads can be started.
+	starved.run(std::ref(unused), [](comp6771::euclidean_vector const&) {});
+	CHECK(unused.produced == 10);
+}
+
+TEST_CASE("Idle tests") {
+	// The source spends nearly all its time asleep, so the stages waiting on it should too.
+	auto pipeline = comp6771::vector_pipeline({.batch_size = 1, .queue_capacity = 1});
+	pipeline.add_stage("unit", comp6771::vector_pipeline::unit_stage());
+	pipeline.add_stage("scale", comp6771::vector_pipeline::scale_stage(2));
+	pipeline.add_stage("filter", comp6771::vector_pipeline::norm_filter_stage(0, 10));
+	auto source = counting_source{100, 4};
+	auto const sleepy = [&source](comp6771::euclidean_vector& v) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(2));
+		return source(v);
+	};
+	auto const wall_start = std::chrono::steady_clock::now();
+	auto const cpu_start = std::clock();
+	pipeline.run(sleepy, [](comp6771::euclidean_vector const&) {});
+	auto const cpu = static_cast<double>(std::clock() - cpu_start) / CLOCKS_PER_SEC;
+	auto const wall =
+	   std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_start).count();
+	CHECK(pipeline.stats().back().items_in > 0);
+	// Four waiting threads spinning or yielding would use several times the wall time.
+	CHECK(cpu < 0.25 * wall);
+}